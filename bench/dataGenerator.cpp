@@ -0,0 +1,121 @@
+#include "dataGenerator.h"
+#include <QDate>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QSqlError>
+#include <QStringList>
+#include "dbConfig.h"
+#include "dbManager.h"
+
+namespace {
+
+const QStringList kAdjectives = {"Silent", "Crimson", "Hidden", "Last", "Golden", "Broken", "Distant", "Winter",
+                                 "Burning", "Forgotten", "Little", "Endless", "Hollow", "Northern", "Quiet", "Wild"};
+const QStringList kNouns = {"River", "Garden", "Empire", "Letter", "Harbor", "Mountain", "Kingdom", "Song",
+                            "Shadow", "Library", "Journey", "Machine", "Island", "Forest", "Tower", "Storm"};
+const QStringList kFirstNames = {"Noa", "Ari", "Maya", "Daniel", "Yael", "Omer", "Tamar", "Itai",
+                                 "Shira", "Eitan", "Lior", "Roni", "Gal", "Adi", "Yonatan", "Michal"};
+const QStringList kLastNames = {"Cohen", "Levi", "Mizrahi", "Peretz", "Biton", "Dahan", "Avraham", "Friedman",
+                                "Katz", "Azulay", "Malka", "Shapiro", "Golan", "Ben-David", "Amar", "Harel"};
+
+constexpr int kChunkRows = 10000;
+
+bool insertChunked(const DbManager& dbManager, const DbTable table, const QStringList& columns,
+                   const qsizetype total, const std::function<QVariantList(qsizetype)>& makeRow)
+{
+    QList<QVariantList> rows;
+    rows.reserve(kChunkRows);
+    for (qsizetype i = 0; i < total; ++i) {
+        rows << makeRow(i);
+        if (rows.size() == kChunkRows || i + 1 == total) {
+            DbTransaction transaction(dbManager);
+            if (!transaction.isActive() || !dbManager.insertRows(table, columns, rows) || !transaction.commit()) {
+                return false;
+            }
+            rows.clear();
+        }
+    }
+    return true;
+}
+
+}
+
+bool DataGenerator::generate(const QString& databasePath, const GeneratorOptions& options)
+{
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = false;
+    {
+        DbConfig config;
+        config.databaseName = databasePath;
+        DbManager dbManager(config);
+        if (!dbManager.open()) {
+            qDebug() << "Error: generator connection failed:" << dbManager.database().lastError().text();
+            return false;
+        }
+        ok = dbManager.createTables();
+        if (ok) {
+            auto [counted, count] = dbManager.executeSql("SELECT COUNT(*) FROM books");
+            const bool empty = counted && count.next() && count.value(0).toInt() == 0;
+            count.finish();
+            if (!empty) {
+                qDebug() << "Error:" << databasePath << "already holds books; generate into a new file.";
+                return false;
+            }
+        }
+
+        QRandomGenerator random(options.seed);
+
+        // Borrow history first, so each book's borrowed_count can match its open borrows
+        QList<int> borrowedCount(options.books, 0);
+        QSet<quint64> openBorrows;
+        QList<QVariantList> borrows;
+        borrows.reserve(options.borrowRecords);
+        for (int i = 0; ok && i < options.borrowRecords; ++i) {
+            const int clientId = 1 + random.bounded(options.clients);
+            const int bookId = 1 + random.bounded(options.books);
+            const QDate borrowDate = options.epoch.addDays(-random.bounded(3 * 365));
+            const QDate returnDate = borrowDate.addDays(14);
+            const quint64 pair = (quint64(clientId) << 32) | quint32(bookId);
+            const bool open = random.bounded(20) == 0 && !openBorrows.contains(pair);
+            if (open) {
+                openBorrows.insert(pair);
+                ++borrowedCount[bookId - 1];
+            }
+            borrows << QVariantList{clientId, bookId, borrowDate, returnDate, open ? 0 : 1};
+        }
+
+        ok = ok && insertChunked(dbManager, DbTable::Books, {"title", "author", "year", "copies", "borrowed_count"},
+            options.books, [&](const qsizetype i) {
+                const QString title = QString("The %1 %2 %3").arg(kAdjectives.at(random.bounded(kAdjectives.size())),
+                                                                 kNouns.at(random.bounded(kNouns.size())))
+                                                             .arg(i + 1);
+                const QString author = QString("%1 %2").arg(kFirstNames.at(random.bounded(kFirstNames.size())),
+                                                            kLastNames.at(random.bounded(kLastNames.size())));
+                const int copies = borrowedCount.at(i) + 1 + random.bounded(5);
+                return QVariantList{title, author, 1900 + random.bounded(125), copies, borrowedCount.at(i)};
+            });
+
+        ok = ok && insertChunked(dbManager, DbTable::Families, {"name"}, options.families, [](const qsizetype i) {
+            return QVariantList{QString("Family %1").arg(i + 1)};
+        });
+
+        ok = ok && insertChunked(dbManager, DbTable::Clients, {"name", "surname", "family"}, options.clients,
+            [&](const qsizetype) {
+                return QVariantList{kFirstNames.at(random.bounded(kFirstNames.size())),
+                                    kLastNames.at(random.bounded(kLastNames.size())),
+                                    QString("Family %1").arg(1 + random.bounded(options.families))};
+            });
+
+        ok = ok && insertChunked(dbManager, DbTable::BorrowRecords,
+            {"client_id", "book_id", "borrow_date", "return_date", "is_returned"},
+            borrows.size(), [&](const qsizetype i) { return borrows.at(i); });
+    }
+
+    qDebug() << (ok ? "Generated" : "Failed generating") << options.books << "books," << options.clients
+             << "clients," << options.families << "families and" << options.borrowRecords
+             << "borrow records in" << timer.elapsed() << "ms";
+    return ok;
+}
@@ -0,0 +1,40 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include "dataGenerator.h"
+
+// Standalone front-end for DataGenerator, e.g.
+//   library_datagen --books 1000000 --clients 200000 library.db
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    GeneratorOptions options;
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Fills a library database with synthetic, reproducible data.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("database", "New SQLite file to create.");
+    const QCommandLineOption books("books", "Number of books.", "n", QString::number(options.books));
+    const QCommandLineOption clients("clients", "Number of clients.", "n", QString::number(options.clients));
+    const QCommandLineOption families("families", "Number of families.", "n", QString::number(options.families));
+    const QCommandLineOption borrows("borrows", "Number of borrow records.", "n", QString::number(options.borrowRecords));
+    const QCommandLineOption seed("seed", "Random seed.", "n", QString::number(options.seed));
+    const QCommandLineOption epoch("epoch", "Date the borrow history runs up to.", "yyyy-MM-dd",
+                                   options.epoch.toString(Qt::ISODate));
+    parser.addOptions({books, clients, families, borrows, seed, epoch});
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(1);
+    }
+    options.books = parser.value(books).toInt();
+    options.clients = parser.value(clients).toInt();
+    options.families = parser.value(families).toInt();
+    options.borrowRecords = parser.value(borrows).toInt();
+    options.seed = parser.value(seed).toUInt();
+    options.epoch = QDate::fromString(parser.value(epoch), Qt::ISODate);
+    if (!options.epoch.isValid() || options.books <= 0 || options.clients <= 0 || options.families <= 0 || options.borrowRecords < 0) {
+        parser.showHelp(1);
+    }
+
+    return DataGenerator::generate(parser.positionalArguments().first(), options) ? 0 : 1;
+}
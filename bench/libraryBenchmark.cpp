@@ -0,0 +1,214 @@
+#include <QCoreApplication>
+#include <QDate>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <memory>
+#include "dataGenerator.h"
+#include "dbManager.h"
+#include "library.h"
+
+/**
+ * Benchmarks the hot paths of Library and DbManager against a generated
+ * database. Sizes come from LMS_BENCH_BOOKS, LMS_BENCH_CLIENTS,
+ * LMS_BENCH_FAMILIES and LMS_BENCH_BORROWS. Results are written as CSV to
+ * benchmark_results.csv unless -o is given on the command line.
+ */
+class LibraryBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void loadBooks();
+    void loadClients();
+    void borrowBook();
+    void returnBook();
+    void catalogEdit();
+    void getBorrowRecordsByClientId();
+    void getClientsByFamilyName();
+    void executeActionSelectById();
+    void executeActionUpdate();
+
+private:
+    static int envInt(const char* name, int fallback);
+
+    QTemporaryDir m_dir;
+    GeneratorOptions m_options;
+    Library* m_library = nullptr;
+    std::unique_ptr<DbManager> m_dbManager;
+    QList<int> m_benchBookIds;
+};
+
+int LibraryBenchmark::envInt(const char* name, const int fallback)
+{
+    bool ok = false;
+    const int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : fallback;
+}
+
+void LibraryBenchmark::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    m_options.books = envInt("LMS_BENCH_BOOKS", m_options.books);
+    m_options.clients = envInt("LMS_BENCH_CLIENTS", m_options.clients);
+    m_options.families = envInt("LMS_BENCH_FAMILIES", m_options.families);
+    m_options.borrowRecords = envInt("LMS_BENCH_BORROWS", m_options.borrowRecords);
+
+    const QString path = m_dir.filePath("library.db");
+    QVERIFY(DataGenerator::generate(path, m_options));
+
+    // Library reads its database path from the environment on first use
+    qputenv("LMS_DB_PATH", path.toUtf8());
+    m_library = Library::instance();
+    QCOMPARE(m_library->bookCount(), m_options.books);
+
+    // A separate pool for the raw DbManager benchmarks
+    DbConfig config;
+    config.databaseName = path;
+    m_dbManager = std::make_unique<DbManager>(config);
+    QVERIFY(m_dbManager->open());
+
+    // Books with enough copies that borrowBook always takes the success path
+    for (int i = 0; i < 10; ++i) {
+        m_library->addBook(QString("Benchmark Copy %1").arg(i), "Bench", 2025, 1000000);
+        m_benchBookIds << m_library->bookAt(m_library->bookCount() - 1)->id();
+    }
+}
+
+void LibraryBenchmark::cleanupTestCase()
+{
+    qDebug() << "Benchmark connection statement cache hits:" << m_dbManager->cacheHits()
+             << "misses:" << m_dbManager->cacheMisses();
+    m_dbManager.reset();
+}
+
+void LibraryBenchmark::loadBooks()
+{
+    QBENCHMARK {
+        m_library->loadBooks();
+    }
+}
+
+void LibraryBenchmark::loadClients()
+{
+    QBENCHMARK {
+        m_library->loadClients();
+    }
+}
+
+void LibraryBenchmark::borrowBook()
+{
+    const QDate borrowDate = m_options.epoch;
+    int i = 0;
+    QBENCHMARK {
+        // Every client borrows each benchmark book at most once. When all
+        // clients have one, a fresh book takes over, so pairs never repeat
+        // however many iterations QBENCHMARK runs (one insert per `clients`
+        // borrows).
+        const int clientId = 1 + i % m_options.clients;
+        const qsizetype bookIndex = i / m_options.clients;
+        if (bookIndex == m_benchBookIds.size()) {
+            m_library->addBook(QString("Benchmark Copy %1").arg(bookIndex), "Bench", 2025, 1000000);
+            m_benchBookIds << m_library->bookAt(m_library->bookCount() - 1)->id();
+        }
+        const int bookId = m_benchBookIds.at(bookIndex);
+        const BorrowRecord record{0, bookId, clientId, borrowDate, borrowDate.addDays(14), false};
+        QVERIFY(m_library->borrowBook(clientId, record) == TransactionResult::Success);
+        ++i;
+    }
+}
+
+void LibraryBenchmark::returnBook()
+{
+    QList<int> openRecords;
+    auto [success, query] = m_dbManager->executeAction(DbAction::Select, DbTable::BorrowRecords, {{"is_returned", 0}});
+    QVERIFY(success);
+    while (query.next()) {
+        openRecords << query.value("id").toInt();
+    }
+    query.finish();
+    QVERIFY(!openRecords.isEmpty());
+
+    // A record can only be returned once, so one timed pass over the open
+    // records replaces QBENCHMARK, which would repeat them as no-ops
+    QElapsedTimer timer;
+    timer.start();
+    for (const int recordId : std::as_const(openRecords)) {
+        QVERIFY(m_library->returnBook(recordId) == TransactionResult::Success);
+    }
+    QTest::setBenchmarkResult(qreal(timer.nsecsElapsed()) / openRecords.size(), QTest::WalltimeNanoseconds);
+
+    auto [stillOpen, openQuery] = m_dbManager->executeAction(DbAction::Select, DbTable::BorrowRecords, {{"is_returned", 0}});
+    QVERIFY(stillOpen);
+    QVERIFY(!openQuery.next());
+}
+
+void LibraryBenchmark::catalogEdit()
+{
+    // What each ledger commit costs the catalog: copy the current version
+    // and patch one book's counters, as refreshBooks does
+    const std::shared_ptr<const Catalog> current = m_library->catalog();
+    const Book book = current->books().at(current->books().size() / 2);
+    QBENCHMARK {
+        Catalog next(*current);
+        QVERIFY(next.updateBook(book));
+    }
+}
+
+void LibraryBenchmark::getBorrowRecordsByClientId()
+{
+    int i = 0;
+    QBENCHMARK {
+        const QList<BorrowRecord> records = m_library->getBorrowRecordsByClientId(1 + i % m_options.clients);
+        Q_UNUSED(records);
+        ++i;
+    }
+}
+
+void LibraryBenchmark::getClientsByFamilyName()
+{
+    int i = 0;
+    QBENCHMARK {
+        const QList<Client> clients = m_library->getClientsByFamilyName(QString("Family %1").arg(1 + i % m_options.families));
+        Q_UNUSED(clients);
+        ++i;
+    }
+}
+
+void LibraryBenchmark::executeActionSelectById()
+{
+    int i = 0;
+    QBENCHMARK {
+        auto [success, query] = m_dbManager->executeAction(DbAction::Select, DbTable::Books, {{"id", 1 + i % m_options.books}});
+        QVERIFY(success && query.next());
+        ++i;
+    }
+}
+
+void LibraryBenchmark::executeActionUpdate()
+{
+    int i = 0;
+    QBENCHMARK {
+        const int id = 1 + i % m_options.books;
+        auto [success, query] = m_dbManager->executeAction(DbAction::Update, DbTable::Books, {{"id", id}, {"year", 2000 + i % 25}});
+        QVERIFY(success);
+        ++i;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    LibraryBenchmark benchmark;
+    QStringList args = app.arguments();
+    // Machine-readable results by default so runs can be compared across commits
+    if (!args.contains("-o")) {
+        args << "-o" << "benchmark_results.csv,csv" << "-o" << "-,txt";
+    }
+    return QTest::qExec(&benchmark, args);
+}
+
+#include "libraryBenchmark.moc"
@@ -0,0 +1,45 @@
+#ifndef ATOMICSNAPSHOT_H
+#define ATOMICSNAPSHOT_H
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @class AtomicSnapshot
+ * @brief Holds the current version of an immutable value for RCU-style reads.
+ *
+ * Readers load() a reference-counted pointer and may keep it as long as they
+ * like; it never changes under them. A writer builds a new version off to the
+ * side and store()s it, which swaps the pointer atomically. The old version
+ * is freed when its last reader lets go. Writers must be serialised by the
+ * caller.
+ */
+template<typename T>
+class AtomicSnapshot
+{
+public:
+    explicit AtomicSnapshot(std::shared_ptr<const T> initial = std::make_shared<const T>())
+        : m_current(std::move(initial))
+    {
+    }
+
+    AtomicSnapshot(const AtomicSnapshot&) = delete;
+    AtomicSnapshot& operator=(const AtomicSnapshot&) = delete;
+
+#if defined(__cpp_lib_atomic_shared_ptr)
+    [[nodiscard]] std::shared_ptr<const T> load() const { return m_current.load(std::memory_order_acquire); }
+    void store(std::shared_ptr<const T> next) { m_current.store(std::move(next), std::memory_order_release); }
+
+private:
+    std::atomic<std::shared_ptr<const T>> m_current;
+#else
+    // Standard libraries without atomic<shared_ptr> still have the free functions
+    [[nodiscard]] std::shared_ptr<const T> load() const { return std::atomic_load_explicit(&m_current, std::memory_order_acquire); }
+    void store(std::shared_ptr<const T> next) { std::atomic_store_explicit(&m_current, std::move(next), std::memory_order_release); }
+
+private:
+    std::shared_ptr<const T> m_current;
+#endif
+};
+
+#endif // ATOMICSNAPSHOT_H
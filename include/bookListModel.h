@@ -0,0 +1,58 @@
+#ifndef BOOKLISTMODEL_H
+#define BOOKLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include "library.h"
+
+/**
+ * @class BookListModel
+ * @brief List model over Library::allBooks() for the main window.
+ *
+ * Rows are formatted only when the view asks for them, and the model
+ * follows the library's per-row signals so a single borrow or copy
+ * change repaints a single row instead of the whole list.
+ *
+ * With a filter set, the model shows just the given books in the given
+ * order, e.g. search results. Inserts and removals are then left to
+ * whoever set the filter.
+ */
+class BookListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        BookIdRole = Qt::UserRole + 1
+    };
+
+    explicit BookListModel(Library* library, QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    void setFilter(const QList<int>& bookIds);
+    void clearFilter();
+    [[nodiscard]] bool isFiltered() const { return m_filtered; }
+
+private slots:
+    void onBookInserted(int row);
+    void onBookRemoved(int row);
+    void onBookChanged(int row);
+    void onBooksUpdated();
+
+private:
+    Library* m_library;
+    // Row count last announced to the views; the library has already
+    // applied a change by the time its signal reaches the model.
+    int m_rowCount = 0;
+
+    bool m_filtered = false;
+    QList<int> m_filterIds;
+    QHash<int, int> m_filterRows; // book id -> row in m_filterIds
+
+    // Row in Library::allBooks() shown at `row`, or -1
+    [[nodiscard]] int libraryRow(int row) const;
+};
+
+#endif // BOOKLISTMODEL_H
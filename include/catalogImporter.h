@@ -0,0 +1,61 @@
+#ifndef CATALOGIMPORTER_H
+#define CATALOGIMPORTER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QTextStream>
+#include "dbManager.h"
+
+/**
+ * @class CatalogImporter
+ * @brief Streams books or clients from a CSV or JSON Lines file into the database.
+ *
+ * The file is read in chunks of chunkSize() rows. Each chunk is written with
+ * multi-row INSERTs inside its own transaction, so memory use stays bounded
+ * and a failure only loses the chunk being written. CSV files need a header
+ * row naming at least the table's required columns; rows whose field count
+ * differs from it are skipped and reported by line number. JSON Lines files
+ * hold one object per line, and the first valid object sets the columns.
+ * Objects that are not valid JSON, or that lack a required column or one
+ * of those columns, are skipped and reported the same way. Columns the
+ * table does not have are ignored in both formats.
+ */
+class CatalogImporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Format {
+        Csv,
+        JsonLines
+    };
+
+    explicit CatalogImporter(const DbManager& dbManager, QObject* parent = nullptr);
+
+    void setChunkSize(int rows) { m_chunkSize = qMax(1, rows); }
+    [[nodiscard]] int chunkSize() const { return m_chunkSize; }
+
+    // Returns the number of rows imported, or -1 if the import stopped on an error
+    qint64 importFile(const QString& path, DbTable table);
+    qint64 importFile(const QString& path, DbTable table, Format format);
+    static Format formatForPath(const QString& path);
+
+signals:
+    void progress(qint64 rows, double rowsPerSecond);
+
+private:
+    qint64 importCsv(QTextStream& in, DbTable table);
+    qint64 importJsonLines(QTextStream& in, DbTable table);
+    bool writeChunk(DbTable table, const QStringList& columns, QList<QVariantList>& rows);
+    // Columns an INSERT must give a value, i.e. NOT NULL or a natural primary key
+    static QStringList requiredColumns(DbTable table);
+    // One record, which may span several lines; `lineNumber` counts the lines read
+    static QStringList readCsvRecord(QTextStream& in, qint64& lineNumber);
+
+    const DbManager& m_dbManager;
+    int m_chunkSize = 5000;
+    qint64 m_imported = 0;
+    qint64 m_startedMs = 0;
+};
+
+#endif // CATALOGIMPORTER_H
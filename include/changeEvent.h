@@ -0,0 +1,66 @@
+#ifndef CHANGEEVENT_H
+#define CHANGEEVENT_H
+
+#include <QDate>
+#include <QHashFunctions>
+#include <QMetaType>
+#include <QString>
+
+/**
+ * @struct ChangeEvent
+ * @brief One committed change, published by Library after the catalog is patched.
+ *
+ * Carries the ids of the affected entities so listeners can update just the
+ * rows that show them. Ids that do not apply to a kind stay -1. Borrow events
+ * also carry the record's dates and state, so listeners never read it back.
+ */
+struct ChangeEvent {
+    enum class Kind {
+        CatalogReloaded, // bulk load or import, listeners should rebuild
+        BookAdded,
+        BookRemoved,
+        BookCopiesChanged,
+        BorrowCreated,
+        BorrowReturned,
+        BorrowExtended,
+        ClientAdded,
+        ClientEdited,
+        ClientRemoved,
+        FamilyAdded
+    };
+
+    Kind kind = Kind::CatalogReloaded;
+    int bookId = -1;
+    int clientId = -1;
+    int recordId = -1;
+    QString family;
+    QDate borrowDate;
+    QDate returnDate;
+    bool isReturned = false;
+
+    static ChangeEvent catalogReloaded() { return {}; }
+    static ChangeEvent book(const Kind kind, const int bookId) { return {kind, bookId}; }
+    static ChangeEvent client(const Kind kind, const int clientId) { return {kind, -1, clientId}; }
+    static ChangeEvent borrow(const Kind kind, const int recordId, const int clientId, const int bookId,
+                              const QDate& borrowDate, const QDate& returnDate, const bool isReturned)
+    {
+        return {kind, bookId, clientId, recordId, QString(), borrowDate, returnDate, isReturned};
+    }
+    static ChangeEvent familyAdded(const QString& family) { return {Kind::FamilyAdded, -1, -1, -1, family}; }
+
+    [[nodiscard]] bool isBorrow() const
+    {
+        return kind == Kind::BorrowCreated || kind == Kind::BorrowReturned || kind == Kind::BorrowExtended;
+    }
+
+    bool operator==(const ChangeEvent& other) const = default;
+};
+
+inline size_t qHash(const ChangeEvent& event, const size_t seed = 0)
+{
+    return qHashMulti(seed, static_cast<int>(event.kind), event.bookId, event.clientId, event.recordId, event.family);
+}
+
+Q_DECLARE_METATYPE(ChangeEvent)
+
+#endif // CHANGEEVENT_H
@@ -0,0 +1,100 @@
+#ifndef CHUNKEDLIST_H
+#define CHUNKEDLIST_H
+
+#include <QList>
+#include <iterator>
+
+/**
+ * @class ChunkedList
+ * @brief Row list split into fixed-size, implicitly shared chunks.
+ *
+ * Copying the list copies one handle per chunk. Replacing or appending a row
+ * on a copy then deep-copies only the chunk that row lives in, so one edit of
+ * a shared version costs O(n / ChunkSize + ChunkSize) instead of O(n).
+ * Removing a row shifts every later row down and touches all later chunks.
+ */
+template<typename T, qsizetype ChunkSize = 256>
+class ChunkedList
+{
+public:
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = qsizetype;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator(const ChunkedList* list, const qsizetype row) : m_list(list), m_row(row) {}
+        const T& operator*() const { return m_list->at(m_row); }
+        const T* operator->() const { return &m_list->at(m_row); }
+        const_iterator& operator++() { ++m_row; return *this; }
+        bool operator==(const const_iterator& other) const { return m_row == other.m_row; }
+        bool operator!=(const const_iterator& other) const { return m_row != other.m_row; }
+
+    private:
+        const ChunkedList* m_list;
+        qsizetype m_row;
+    };
+
+    ChunkedList() = default;
+    explicit ChunkedList(const QList<T>& rows)
+    {
+        m_chunks.reserve((rows.size() + ChunkSize - 1) / ChunkSize);
+        for (qsizetype from = 0; from < rows.size(); from += ChunkSize) {
+            m_chunks.append(rows.mid(from, ChunkSize));
+        }
+        m_size = rows.size();
+    }
+
+    [[nodiscard]] qsizetype size() const { return m_size; }
+    [[nodiscard]] bool isEmpty() const { return m_size == 0; }
+    [[nodiscard]] const T& at(const qsizetype row) const { return m_chunks.at(row / ChunkSize).at(row % ChunkSize); }
+    [[nodiscard]] const T& last() const { return at(m_size - 1); }
+
+    void replace(const qsizetype row, const T& value) { m_chunks[row / ChunkSize][row % ChunkSize] = value; }
+
+    void append(const T& value)
+    {
+        if (m_size % ChunkSize == 0) {
+            m_chunks.append(QList<T>());
+            m_chunks.last().reserve(ChunkSize);
+        }
+        m_chunks.last().append(value);
+        ++m_size;
+    }
+
+    void removeAt(const qsizetype row)
+    {
+        const qsizetype chunk = row / ChunkSize;
+        m_chunks[chunk].removeAt(row % ChunkSize);
+        // Keep every chunk but the last full so rows map to chunks by division
+        for (qsizetype next = chunk + 1; next < m_chunks.size(); ++next) {
+            m_chunks[next - 1].append(m_chunks[next].takeFirst());
+        }
+        if (m_chunks.last().isEmpty()) {
+            m_chunks.removeLast();
+        }
+        --m_size;
+    }
+
+    [[nodiscard]] QList<T> toList() const
+    {
+        QList<T> rows;
+        rows.reserve(m_size);
+        for (const QList<T>& chunk : m_chunks) {
+            rows.append(chunk);
+        }
+        return rows;
+    }
+
+    [[nodiscard]] const_iterator begin() const { return const_iterator(this, 0); }
+    [[nodiscard]] const_iterator end() const { return const_iterator(this, m_size); }
+
+private:
+    QList<QList<T>> m_chunks;
+    qsizetype m_size = 0;
+};
+
+#endif // CHUNKEDLIST_H
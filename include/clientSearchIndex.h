@@ -0,0 +1,61 @@
+#ifndef CLIENTSEARCHINDEX_H
+#define CLIENTSEARCHINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include "client.h"
+
+/**
+ * @class ClientSearchIndex
+ * @brief Trigram index over client name, surname and family for fuzzy lookup.
+ *
+ * Each word is lower-cased, stripped of diacritics and padded ("  ann ")
+ * before it is cut into trigrams, so prefixes and whole words weigh more
+ * than fragments. A query scores every client that shares a trigram with it
+ * by the Dice coefficient, so a typo or two still finds the client.
+ *
+ * Clients live in dense slots; postings lists hold slots and the scoring
+ * pass counts into a flat per-thread array, so a lookup touches only the
+ * postings of the query's trigrams and never the full client list. Each slot
+ * remembers where it sits in every one of its postings, so removing a client
+ * swaps the last entry into its place instead of scanning the lists. All
+ * members are implicitly shared, so copying the index is cheap and find()
+ * may run on several threads at once.
+ */
+class ClientSearchIndex
+{
+public:
+    struct Match {
+        int clientId;
+        double score; // 0..1, 1 when the trigram sets are identical
+    };
+
+    void clear();
+    void insert(const Client& client);
+    void remove(int clientId);
+    void update(const Client& client);
+
+    // Up to `limit` clients scoring at least `minScore`, best first
+    [[nodiscard]] QList<Match> find(const QString& query, int limit, double minScore = 0.3) const;
+
+    [[nodiscard]] qsizetype size() const { return m_slotOfClient.size(); }
+
+private:
+    using Trigram = quint64;
+
+    static QList<Trigram> trigrams(const QString& text);
+
+    // slot -> client id, -1 for a free slot
+    QList<int> m_clientOfSlot;
+    QHash<int, int> m_slotOfClient;
+    QList<int> m_freeSlots;
+    // slot -> its distinct trigrams, kept for removal and for scoring
+    QList<QList<Trigram>> m_slotTrigrams;
+    // slot -> index of the slot in the posting of each of its trigrams
+    QList<QList<int>> m_slotPositions;
+    // Unordered; find() does not depend on the order of a posting
+    QHash<Trigram, QList<int>> m_postings;
+};
+
+#endif // CLIENTSEARCHINDEX_H
@@ -0,0 +1,56 @@
+#ifndef DBCONFIG_H
+#define DBCONFIG_H
+
+#include <QSqlDatabase>
+#include <QString>
+
+/**
+ * @struct DbConfig
+ * @brief SQLite connection settings applied to every connection the library opens.
+ *
+ * Defaults favour concurrent desk traffic (WAL journal, NORMAL sync). Values
+ * are read from the [database] group of an INI file and may be overridden
+ * by environment variables:
+ *
+ *   LMS_CONFIG        path of the INI file (default: library.ini)
+ *   LMS_DB_PATH       database file
+ *   LMS_JOURNAL_MODE  DELETE | TRUNCATE | PERSIST | MEMORY | WAL | OFF
+ *   LMS_SYNCHRONOUS   OFF | NORMAL | FULL | EXTRA
+ *   LMS_CACHE_SIZE    pages, or KiB when negative
+ *   LMS_MMAP_SIZE     bytes
+ *   LMS_TEMP_STORE    DEFAULT | FILE | MEMORY
+ *   LMS_BUSY_TIMEOUT  ms SQLite waits on a lock held by another connection
+ *   LMS_BUSY_RETRIES  extra attempts after the busy timeout ran out
+ *
+ * Query instrumentation lives in the [metrics] group:
+ *
+ *   LMS_SLOW_QUERY_MS   statements at or above this many ms are logged
+ *   LMS_SLOW_QUERY_LOG  file for the slow query log (default: debug log)
+ *   LMS_STATS_DUMP_SEC  interval of the periodic statistics dump, 0 disables it
+ */
+struct DbConfig {
+    QString databaseName = "library.db";
+    QString journalMode = "WAL";
+    QString synchronous = "NORMAL";
+    int cacheSize = -65536;          // 64 MiB
+    qint64 mmapSize = 268435456;     // 256 MiB
+    QString tempStore = "MEMORY";
+    int busyTimeoutMs = 5000;
+    int busyRetries = 3;
+
+    int slowQueryMs = 50;
+    QString slowQueryLog;
+    int statsDumpIntervalSec = 300;
+
+    static DbConfig load();
+    static DbConfig load(const QString& path);
+
+    // Runs the PRAGMAs on an open connection
+    bool apply(const QSqlDatabase& db) const;
+    // Logs the values SQLite actually uses on a connection; called once at startup
+    void logEffective(const QSqlDatabase& db) const;
+    // Pushes the metrics settings to QueryMetrics
+    void applyMetrics() const;
+};
+
+#endif // DBCONFIG_H
@@ -1,10 +1,19 @@
 #ifndef DBMANAGER_H
 #define DBMANAGER_H
 
+#include <QDate>
 #include <QSqlDatabase>
+#include <QSqlError>
 #include <QSqlQuery>
 #include <QDebug>
 #include <QVariantMap>
+#include <QHash>
+#include <QStringList>
+#include <QMutex>
+#include <QThread>
+#include <atomic>
+#include <functional>
+#include "dbConfig.h"
 
 // Define enums for actions and tables
 enum class DbAction {
@@ -21,53 +30,208 @@ enum class DbTable {
     BorrowRecords
 };
 
-// Define structs for table schemas
+// Define structs for table schemas; one row of each table, as decoded by
+// RowDecoder (see tableDescriptor.h)
 struct BookSchema {
-    int id;
+    int id = 0;
     QString title;
-    QString isbn;
-    int year;
-    int copies;
-    int borrowed_count;
+    QString author;
+    int year = 0;
+    int copies = 0;
+    int borrowed_count = 0;
 };
 
 struct ClientSchema {
-    int id;
+    int id = 0;
     QString name;
     QString surname;
     QString family;
 };
 
 struct FamilySchema {
-    int id;
     QString name;
 };
 
 struct BorrowRecordSchema {
-    int id;
-    int book_id;
-    int client_id;
-    QString borrow_date;
-    QString return_date;
-    bool is_returned;
+    int id = 0;
+    int book_id = 0;
+    int client_id = 0;
+    QDate borrow_date;
+    QDate return_date;
+    bool is_returned = false;
 };
 
+// Secondary index on a table, created alongside the table itself
+struct IndexSchema {
+    QString name;
+    QStringList columns;
+};
+
+// A statement prepared once and kept alive between calls to executeAction.
+// Only the bound values change from one call to the next.
+struct PreparedStatement {
+    QSqlQuery query;
+    QStringList columns; // order of the positional placeholders
+    QString label;       // key of its latency statistics in QueryMetrics
+    QString sql;         // text it was prepared from, to prepare it again
+};
+
+// One pooled connection and the state that is only valid on its thread
+struct DbConnection {
+    QString name;
+    QSqlDatabase db;
+    QHash<QString, PreparedStatement> statements;
+    int transactionDepth = 0;
+    QMetaObject::Connection threadFinished; // releases the connection when its thread ends
+};
+
+// Position of the last row of a page in a keyset scan. The default cursor
+// starts at the beginning; `value` is only needed when ordering by a column
+// other than the table's key.
+struct PageCursor {
+    QVariant value;
+    QVariant key;
+    [[nodiscard]] bool atStart() const { return !key.isValid(); }
+};
+
+/**
+ * @class DbManager
+ * @brief Statement execution over a pool of SQLite connections, one per thread.
+ *
+ * Qt connections may only be used on the thread that opened them, so each
+ * thread that calls in gets its own named connection, opened lazily against
+ * the configured database with the same pragmas. Statement caches and
+ * transaction state are per connection. Reads run in parallel (WAL lets
+ * readers proceed alongside a writer); writes and write transactions take a
+ * process-wide lock so only one thread writes at a time.
+ */
 class DbManager
 {
 public:
-    explicit DbManager(QSqlDatabase& db);
+    explicit DbManager(const DbConfig& config);
     ~DbManager();
+    DbManager(const DbManager&) = delete;
+    DbManager& operator=(const DbManager&) = delete;
+
+    // Opens the calling thread's connection if needed; false if it cannot be opened
+    bool open() const;
+    // The calling thread's connection
+    [[nodiscard]] QSqlDatabase database() const { return connection().db; }
+    // Closes the calling thread's connection; the next call opens a new one
+    void releaseConnection() const;
+    [[nodiscard]] qsizetype connectionCount() const;
+
     bool createTables() const;
+    static QString getTableName(DbTable table);
     static QVariantMap getSchemaForTable(DbTable table);
+    static QList<IndexSchema> getIndexesForTable(DbTable table);
+    // Runs a cached prepared statement and hands back a query sharing its
+    // result set. A SELECT cursor stays the caller's until it has been read
+    // to the end or finish()ed: a call with the same statement before that
+    // gets a freshly prepared one, and the caller's rows are left alone. Call
+    // finish() on cursors you stop reading early, single-row lookups
+    // included: an open cursor defeats the cache and holds a read
+    // transaction that blocks WAL checkpoints. Write results (numRowsAffected, lastInsertId) must be read
+    // before the same statement runs again on this thread.
     std::pair<bool, QSqlQuery> executeAction(DbAction action, DbTable table, const QVariantMap& args) const;
+    // Runs a hand-written statement (joins, aggregates) with positional `?`
+    // values. Statements are cached by their SQL text and follow the same
+    // cursor rule as executeAction's.
+    std::pair<bool, QSqlQuery> executeSql(const QString& sql, const QVariantList& values = {}) const;
+    // Streams the rows matching `where` to `visitor` through a forward-only
+    // cursor, so no result set is materialised. Return false from the visitor
+    // to stop early. The visitor may run other queries, including ones of the
+    // same shape, which are then prepared afresh.
+    bool forEachRow(DbTable table, const QVariantMap& where, const std::function<bool(const QSqlQuery&)>& visitor) const;
+    // Multi-row INSERT of `rows`, each holding one value per entry of `columns`.
+    // Run it inside a transaction so the whole batch costs a single commit.
+    bool insertRows(DbTable table, const QStringList& columns, const QList<QVariantList>& rows) const;
+    // Keyset (seek) pagination: up to `limit` rows matching `where`, ordered by
+    // `orderColumn` then the table key, starting after `after`. Each page is one
+    // index seek, so its cost does not grow with how far in the scan is, as
+    // long as an index covers (where columns, orderColumn).
+    std::pair<bool, QSqlQuery> selectPage(DbTable table, const QVariantMap& where, const QString& orderColumn,
+                                          const PageCursor& after, int limit) const;
+    // Cursor just past `row`, to request the page that follows it
+    static PageCursor cursorAfter(DbTable table, const QString& orderColumn, const QSqlQuery& row);
+    // "id", or "name" for families
+    static QString keyColumn(DbTable table);
+
+    // Transactions. Nested calls are mapped onto savepoints so an inner
+    // rollback only undoes its own work.
+    bool beginTransaction() const;
+    bool commitTransaction() const;
+    bool rollbackTransaction() const;
+    [[nodiscard]] bool inTransaction() const { return connection().transactionDepth > 0; }
+
+    // Prepared statement cache statistics, summed over all connections
+    [[nodiscard]] quint64 cacheHits() const { return m_cacheHits; }
+    [[nodiscard]] quint64 cacheMisses() const { return m_cacheMisses; }
+    // Drops the calling thread's cached statements
+    void clearStatementCache() const;
+
+    // True once createTables() set up the books_fts index (needs SQLite built with FTS5)
+    [[nodiscard]] bool hasFullTextSearch() const { return m_fullTextSearch; }
 
 private:
-    QSqlDatabase& m_db;
+    DbConfig m_config;
+    QString m_poolName;        // prefix of the connection names, unique per manager
+    QThread* m_ownerThread;
+    mutable QMutex m_poolMutex; // guards m_connections
+    mutable QHash<QThread*, DbConnection*> m_connections;
+    mutable QMutex m_writeMutex; // held by the writing thread for a statement or a whole transaction
+    DbConnection& connection() const;
+    static void closeConnection(DbConnection* connection);
+    static bool isWrite(const QString& sql);
+    static bool isBusy(const QSqlError& error);
+    // Lowest SQLITE_MAX_VARIABLE_NUMBER across SQLite versions Qt may ship with
+    static constexpr int MaxBoundParameters = 999;
+    PreparedStatement* preparedStatement(DbAction action, DbTable table, const QVariantMap& args) const;
+    PreparedStatement* insertRowsStatement(DbTable table, const QStringList& columns, int rowCount) const;
+    PreparedStatement* pageStatement(DbTable table, const QVariantMap& where, const QString& orderColumn, bool first) const;
+    PreparedStatement* findStatement(const QString& key) const;
+    // The statement's query, ready for new bindings. If a caller may still be
+    // reading its last result set, a fresh query takes its place in the cache.
+    QSqlQuery& reusableQuery(PreparedStatement& statement) const;
+    PreparedStatement* storeStatement(const QString& key, const QString& sql, const QStringList& columns,
+                                      const QString& label, bool forwardOnly = false) const;
+    // Runs the query (or sql, when given) and records its latency under label
+    bool execTimed(QSqlQuery& query, const QString& label, const QString& sql = {}) const;
+    static QString statementKey(DbAction action, DbTable table, const QVariantMap& args);
+    mutable std::atomic<quint64> m_cacheHits = 0;
+    mutable std::atomic<quint64> m_cacheMisses = 0;
+    mutable std::atomic<bool> m_fullTextSearch = false;
+    bool execRaw(const QString& sql) const;
+    bool createFullTextIndex() const;
     static QString tableSchemaToSql(DbTable table);
+    static QStringList tableIndexesToSql(DbTable table);
     [[nodiscard]] QUuid generateUUID(const QString& args) const;
     QUuid generateUUID(const DbTable table, const QVariantMap& args) const;
-    static QString getTableName(DbTable table);
     QString _key = "library_management_system_key";
 };
 
+/**
+ * @class DbTransaction
+ * @brief Scoped transaction on a DbManager.
+ *
+ * Begins a transaction on construction and rolls it back on destruction
+ * unless commit() was called first.
+ */
+class DbTransaction
+{
+public:
+    explicit DbTransaction(const DbManager& dbManager);
+    ~DbTransaction();
+    DbTransaction(const DbTransaction&) = delete;
+    DbTransaction& operator=(const DbTransaction&) = delete;
+
+    [[nodiscard]] bool isActive() const { return m_active; }
+    bool commit();
+    void rollback();
+
+private:
+    const DbManager& m_dbManager;
+    bool m_active;
+};
+
 #endif // DBMANAGER_H
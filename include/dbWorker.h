@@ -0,0 +1,53 @@
+#ifndef DBWORKER_H
+#define DBWORKER_H
+
+#include <QFuture>
+#include <QPromise>
+#include <QThreadPool>
+#include <functional>
+#include <memory>
+#include "dbManager.h"
+
+/**
+ * @class DbWorker
+ * @brief Runs database jobs on a pool of threads, each with its own connection.
+ *
+ * Jobs share the application's DbManager, which opens a connection for each
+ * pool thread on first use, so read-only jobs run in parallel across cores
+ * while DbManager keeps writes serialised. Pool threads do not expire and
+ * keep their connection until the worker is destroyed. Results are
+ * delivered through QFuture; attach a QFutureWatcher to be notified on the
+ * GUI thread. Jobs may finish in any order.
+ */
+class DbWorker
+{
+public:
+    explicit DbWorker(const DbManager& dbManager, int maxThreads = QThread::idealThreadCount());
+    ~DbWorker();
+    DbWorker(const DbWorker&) = delete;
+    DbWorker& operator=(const DbWorker&) = delete;
+
+    // Queues `job` for the pool. T must be default constructible; a default
+    // value is reported if the thread's connection cannot be opened.
+    template<typename T>
+    QFuture<T> submit(std::function<T(const DbManager&)> job);
+
+private:
+    const DbManager& m_dbManager;
+    QThreadPool m_pool;
+};
+
+template<typename T>
+QFuture<T> DbWorker::submit(std::function<T(const DbManager&)> job)
+{
+    auto promise = std::make_shared<QPromise<T>>();
+    QFuture<T> future = promise->future();
+    promise->start();
+    m_pool.start([this, promise, job = std::move(job)]() {
+        promise->addResult(m_dbManager.open() ? job(m_dbManager) : T{});
+        promise->finish();
+    });
+    return future;
+}
+
+#endif // DBWORKER_H
@@ -0,0 +1,35 @@
+#ifndef HISTORYEXPORTER_H
+#define HISTORYEXPORTER_H
+
+#include <QString>
+#include "dbManager.h"
+
+/**
+ * @class HistoryExporter
+ * @brief Writes the borrow_records table to CSV or JSON Lines in constant memory.
+ *
+ * Rows are pulled one at a time from a forward-only cursor and written
+ * straight to the output file; nothing is collected in between.
+ */
+class HistoryExporter
+{
+public:
+    enum class Format {
+        Csv,
+        JsonLines
+    };
+
+    explicit HistoryExporter(const DbManager& dbManager);
+
+    // Returns the number of rows written, or -1 on failure
+    [[nodiscard]] qint64 exportBorrowRecords(const QString& path) const;
+    [[nodiscard]] qint64 exportBorrowRecords(const QString& path, Format format) const;
+    static Format formatForPath(const QString& path);
+
+private:
+    static QString csvField(const QString& value);
+
+    const DbManager& m_dbManager;
+};
+
+#endif // HISTORYEXPORTER_H
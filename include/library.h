@@ -3,16 +3,31 @@
 
 #include <QObject>
 #include <QList>
+#include <QMutex>
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QDate>
 #include <QUuid>
+#include <memory>
+#include <optional>
+#include <QTimer>
+#include "atomicSnapshot.h"
 #include "book.h"
 #include "client.h"
-#include "dbmanager.h"
+#include "dbManager.h"
+#include "dbConfig.h"
+#include "catalog.h"
+#include "changeEvent.h"
+#include "dbWorker.h"
+#include "queryMetrics.h"
 
 // Forward declaration
 struct BorrowRecord;
+struct BorrowRecordWithBook;
+struct BorrowRecordWithClient;
+struct CommandOutcome;
+struct LibraryCommand;
+class LibraryWriter;
 
 enum class TransactionResult
 {
@@ -25,9 +40,19 @@ enum class TransactionResult
     Failure_NotAvailableBook,
     Failure_NoCopies,
     Failure_AlreadyBorrowed,
+    Failure_RecordNotFound,
+    Failure_AlreadyReturned,
 
 };
 
+// One page of a keyset scan; pass `next` back to get the page after it
+template<typename T>
+struct Page {
+    QList<T> items;
+    PageCursor next;
+    bool hasMore = false;
+};
+
 class Library final : public QObject {
     Q_OBJECT
 
@@ -38,14 +63,39 @@ public:
         static Library instance;
         return &instance;
     }
+    // Full reload of books, clients and families from the database. Mutations
+    // patch the in-memory catalog directly, so this is only needed as an admin
+    // check; returns the number of rows that differed, or -1 on failure.
+    int reloadAndVerify();
+
+    // Bulk import from CSV or JSON Lines (chosen by file extension). The
+    // catalog is rebuilt once at the end; returns rows imported or -1.
+    qint64 importBooks(const QString& path);
+    qint64 importClients(const QString& path);
+    // Streams the whole borrow history to CSV or JSON Lines; returns rows written or -1
+    [[nodiscard]] qint64 exportBorrowHistory(const QString& path) const;
+
+    // Immutable, reference-counted version of the in-memory catalog, swapped
+    // atomically on every change. Safe to take from any thread and to keep
+    // for as long as needed; it never changes underneath the holder.
+    [[nodiscard]] std::shared_ptr<const Catalog> catalog() const;
+
     // Book management
     void addBook(const QString& title, const QString& author, int year, int copies);
     void loadBooks();
-    [[nodiscard]] const QList<Book>& allBooks() const;
+    // Copies every row; list views should use bookCount() and bookAt()
+    [[nodiscard]] QList<Book> allBooks() const;
+    [[nodiscard]] int bookCount() const;
+    [[nodiscard]] std::optional<Book> bookAt(int row) const;
     [[nodiscard]] QList<Book> getAvailableBooks() const;
     void removeBook(int index);
     void addCopies(int index, int numCopies);
     void removeCopy(int index);
+    // Row of the book in allBooks(), or -1
+    [[nodiscard]] int bookRow(int id) const;
+    // Books whose title or author has a word starting with every term of
+    // `text`, best match first (bm25, title weighted over author)
+    [[nodiscard]] QList<Book> searchBooks(const QString& text, int limit = 50, int offset = 0) const;
 
     // Client management
     void addClient(const Client& client);
@@ -53,47 +103,108 @@ public:
     void removeClient(const Client& client);
     void loadClients();
     [[nodiscard]] Client getClientById(int id) const;
-    [[nodiscard]] const QList<Client>& allClients() const;
-    [[nodiscard]] const QList<QString>& allFamilies() const;
+    [[nodiscard]] QList<Client> allClients() const;
+    [[nodiscard]] QList<QString> allFamilies() const;
     [[nodiscard]] QList<Client> getClientsByFamilyName(const QString& familyName) const;
-    bool updateClient(int id, const QString& name, const QString& surname, const QString& family) const;
-    void on_familyListWidget_doubleClicked(QWidget* p, const Client& client) const;
+    bool updateClient(int id, const QString& name, const QString& surname, const QString& family);
+    // Typo-tolerant lookup over name, surname and family, best match first
+    [[nodiscard]] QList<Client> findClients(const QString& query, int limit = 20) const;
 
-    // Borrow management
+    // Borrow management. These queue the command for the writer thread and
+    // wait for its commit; the catalog and changed() are up to date on return.
     TransactionResult borrowBook(int clientId, const BorrowRecord& record);
-    [[nodiscard]] TransactionResult returnBook(const int& borrowRecordId) const;
-    bool extendBorrowTime(const int& borrowRecordId, int days) const;
-    Book* getBookById(int id) const;
+    [[nodiscard]] TransactionResult returnBook(const int& borrowRecordId);
+    bool extendBorrowTime(const int& borrowRecordId, int days);
+    [[nodiscard]] std::optional<BorrowRecord> getBorrowRecordById(int id) const;
+    [[nodiscard]] std::optional<Book> getBookById(int id) const;
     [[nodiscard]] QList<BorrowRecord> getBorrowRecordsByClientId(int clientId) const;
+    // Queue the same operations for the single writer thread; callable from any
+    // thread. Queued commands are committed in batches, and the catalog and
+    // changed() follow on this object's thread after the commit.
+    QFuture<TransactionResult> borrowBookAsync(int clientId, const BorrowRecord& record) const;
+    QFuture<TransactionResult> returnBookAsync(int borrowRecordId) const;
+    QFuture<TransactionResult> extendBorrowTimeAsync(int borrowRecordId, int days) const;
+    QFuture<TransactionResult> addCopiesAsync(int bookId, int numCopies) const;
     QList<Book> getBorrowedBooksByClient(const QString& clientId) const;
     QList<BorrowRecord>getBorrowRecordsByBookId(int bookId) const;
 
+    // A client's borrow records joined with each book's title and author in one query
+    [[nodiscard]] QList<BorrowRecordWithBook> getClientBorrowHistory(int clientId) const;
+    // A book's borrow records joined with each borrower's name in one query
+    [[nodiscard]] QList<BorrowRecordWithClient> getBookBorrowHistory(int bookId) const;
+
+    // Page-at-a-time reads straight from the database, for views and exports
+    // that should not hold a whole table. Each page is one index seek.
+    // Books can be ordered by "id" or "title".
+    [[nodiscard]] Page<Book> booksPage(const PageCursor& after = {}, int limit = 500, const QString& orderBy = "id") const;
+    [[nodiscard]] Page<Client> clientsPage(const PageCursor& after = {}, int limit = 500) const;
+    [[nodiscard]] Page<BorrowRecord> borrowRecordsPage(int clientId, const PageCursor& after = {}, int limit = 100) const;
+    [[nodiscard]] Page<BorrowRecord> borrowHistoryPage(const PageCursor& after = {}, int limit = 1000) const;
+
+    // Queries run on the database worker thread; the GUI thread attaches a
+    // QFutureWatcher and renders when the result arrives
+    [[nodiscard]] QFuture<QList<BorrowRecordWithBook>> getClientBorrowHistoryAsync(int clientId) const;
+    [[nodiscard]] QFuture<QList<BorrowRecordWithClient>> getBookBorrowHistoryAsync(int bookId) const;
+
+    // Latency statistics of every statement run so far, slowest total first
+    [[nodiscard]] QList<QueryStats> queryStats() const;
+    void dumpQueryStats() const;
+
 signals:
+    // Whole book list replaced (load, reload, import)
     void booksUpdated();
-    void clientsUpdated();
-    void familiesUpdated();
+    // Single-row changes; `row` indexes allBooks()
+    void bookInserted(int row);
+    void bookRemoved(int row);
+    void bookChanged(int row);
+    // Every committed change with the ids it touched; the window layer
+    // subscribes to this and patches the affected rows
+    void changed(const ChangeEvent& event);
+    void importProgress(qint64 rows, double rowsPerSecond);
 
 private:
     Library();
     bool connectToDatabase();
-    void saveFamily(const QString& family) const;
+    void saveFamily(const QString& family);
     void loadFamilies();
     // Helper methods
-    Book* findBookByTitleAndAuthor(const QString& title, const QString& author) const;
-    static Book getBookFromQuery(const QSqlQuery& query);
-    static Client getClientFromQuery(const QSqlQuery& query);
-    static BorrowRecord getBorrowRecordFromQuery(const QSqlQuery& query);
+    [[nodiscard]] std::optional<Book> findBookByTitleAndAuthor(const QString& title, const QString& author) const;
+    // Re-reads books' counters from the database, which other desks may have
+    // changed, and patches their catalog rows
+    void refreshBooks(const QList<int>& bookIds);
+    // Patches the catalog and announces the commands' committed changes
+    void publish(const QList<CommandOutcome>& outcomes);
+    // Publishes what the writer has committed so far, in commit order
+    void publishCommitted();
+    // Runs a command on the writer thread and waits for it
+    CommandOutcome submitAndWait(const LibraryCommand& command);
+    // Builds the next catalog version from a copy of the current one and
+    // publishes it; only called on this object's thread
+    template<typename Edit>
+    void editCatalog(Edit&& edit);
+    // Domain objects from rows decoded by RowDecoder
+    static Book bookFromRow(const BookSchema& row);
+    static Client clientFromRow(const ClientSchema& row);
+    static BorrowRecord borrowRecordFromRow(const BorrowRecordSchema& row);
     static QList<BorrowRecord> getBorrowRecordsListByQuery(QSqlQuery& query);
+    static QList<BorrowRecord> selectBorrowRecords(const DbManager& db, const QVariantMap& args);
+    static QList<BorrowRecordWithBook> selectClientBorrowHistory(const DbManager& db, int clientId);
+    static QList<BorrowRecordWithClient> selectBookBorrowHistory(const DbManager& db, int bookId);
     static QList<Client>getClientsListByQuery(QSqlQuery& query);
     static QList<Book>getBooksListByQuery(QSqlQuery& query);
+    static QStringList searchTerms(const QString& text);
+    QList<Book> scanBooks(const QStringList& terms, int limit, int offset) const;
 
 
 private:
-    QList<Book> _books;
-    QList<Client> _clients;
-    QList<QString> _families;
-    QSqlDatabase _db;
-    DbManager* _dbManager; // Pointer to the new DbManager
+    AtomicSnapshot<Catalog> _catalog; // current catalog version, swapped on every change
+    DbConfig _config;
+    DbManager* _dbManager = nullptr; // Connection pool, one connection per calling thread
+    DbWorker* _worker = nullptr; // Runs the async queries on pool threads
+    LibraryWriter* _writer = nullptr; // Single writer draining the command queue
+    QMutex _committedMutex;
+    QList<CommandOutcome> _committed; // committed by the writer, not yet published
+    QTimer _statsTimer;          // Periodic dump of the query statistics
 };
 
 struct BorrowRecord {
@@ -104,4 +215,16 @@ struct BorrowRecord {
     QDate returnDate;
     bool isReturned;
 };
+
+struct BorrowRecordWithBook {
+    BorrowRecord record;
+    QString bookTitle;
+    QString bookAuthor;
+};
+
+struct BorrowRecordWithClient {
+    BorrowRecord record;
+    QString clientName;
+    QString clientSurname;
+};
 #endif // LIBRARY_H
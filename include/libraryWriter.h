@@ -0,0 +1,110 @@
+#ifndef LIBRARYWRITER_H
+#define LIBRARYWRITER_H
+
+#include <QDate>
+#include <QFuture>
+#include <QList>
+#include <QPromise>
+#include <QSemaphore>
+#include <QThread>
+#include <functional>
+#include <memory>
+#include <optional>
+#include "changeEvent.h"
+#include "dbManager.h"
+#include "library.h"
+#include "mpscQueue.h"
+
+// One mutating operation on the borrow ledger, as queued by a desk or kiosk
+struct LibraryCommand {
+    enum class Kind {
+        Borrow,
+        Return,
+        Extend,
+        AddCopies,
+        RemoveCopy
+    };
+
+    Kind kind = Kind::Borrow;
+    int clientId = -1;
+    int bookId = -1;
+    int recordId = -1;
+    QDate borrowDate;
+    QDate returnDate;
+    int amount = 0; // days for Extend, copies for AddCopies
+
+    static LibraryCommand borrowBook(const int clientId, const BorrowRecord& record)
+    {
+        return {Kind::Borrow, clientId, record.bookId, -1, record.borrowDate, record.returnDate};
+    }
+    static LibraryCommand returnBook(const int recordId) { return {Kind::Return, -1, -1, recordId}; }
+    static LibraryCommand extendBorrowTime(const int recordId, const int days)
+    {
+        return {Kind::Extend, -1, -1, recordId, {}, {}, days};
+    }
+    static LibraryCommand addCopies(const int bookId, const int copies)
+    {
+        return {Kind::AddCopies, -1, bookId, -1, {}, {}, copies};
+    }
+    static LibraryCommand removeCopy(const int bookId) { return {Kind::RemoveCopy, -1, bookId}; }
+};
+
+// What a command did. `bookId` names a book whose counters should be
+// re-read into the catalog; `event` is set once the change is committed.
+struct CommandOutcome {
+    TransactionResult result = TransactionResult::Failure_DBFailed;
+    int bookId = -1;
+    std::optional<ChangeEvent> event;
+};
+
+/**
+ * @class LibraryWriter
+ * @brief Single writer thread behind a lock-free command queue.
+ *
+ * Any thread may submit commands; they are pushed onto an MpscQueue and the
+ * writer drains up to `maxBatch` of them at a time. A batch runs in one
+ * transaction with a savepoint per command, so a failed command only undoes
+ * itself and the whole batch costs a single commit (group commit). After
+ * that commit `committed` is called on the writer thread with every outcome
+ * of the batch, then the batch's futures are completed. This thread is the
+ * only one that runs commands.
+ */
+class LibraryWriter
+{
+public:
+    using CommittedHandler = std::function<void(const QList<CommandOutcome>&)>;
+
+    LibraryWriter(const DbManager& dbManager, CommittedHandler committed, int maxBatch = 64);
+    ~LibraryWriter();
+    LibraryWriter(const LibraryWriter&) = delete;
+    LibraryWriter& operator=(const LibraryWriter&) = delete;
+
+    // Thread safe
+    QFuture<TransactionResult> submit(const LibraryCommand& command);
+
+private:
+    struct PendingCommand {
+        LibraryCommand command;
+        std::shared_ptr<QPromise<TransactionResult>> promise; // null asks the writer to stop
+    };
+
+    void run();
+    void runBatch(QList<PendingCommand>& batch);
+    // Runs one command on the writer's connection; inside the batch
+    // transaction it becomes a savepoint
+    static CommandOutcome execute(const DbManager& dbManager, const LibraryCommand& command);
+    static CommandOutcome borrowBook(const DbManager& dbManager, const LibraryCommand& command);
+    static CommandOutcome returnBook(const DbManager& dbManager, const LibraryCommand& command);
+    static CommandOutcome extendBorrowTime(const DbManager& dbManager, const LibraryCommand& command);
+    static CommandOutcome addCopies(const DbManager& dbManager, const LibraryCommand& command);
+    static CommandOutcome removeCopy(const DbManager& dbManager, const LibraryCommand& command);
+
+    const DbManager& m_dbManager;
+    CommittedHandler m_committed;
+    const int m_maxBatch;
+    MpscQueue<PendingCommand> m_queue;
+    QSemaphore m_pending; // one count per fully pushed command
+    QThread* m_thread = nullptr;
+};
+
+#endif // LIBRARYWRITER_H
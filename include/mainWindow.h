@@ -3,6 +3,8 @@
 
 #include <QMainWindow>
 #include <QListWidget>
+#include <QHash>
+#include <QTimer>
 #include <QInputDialog>
 #include <QMessageBox>
 #include "library.h"
@@ -12,6 +14,8 @@
 namespace Ui {
     class MainWindow;
 }
+class BookListModel;
+
 class MainWindow : public QMainWindow
 {
 
@@ -19,28 +23,40 @@ private:
     Q_OBJECT
 
 public:
-    void handleEvent(EventType event);
+    void handleEvent(const ChangeBatch& changes);
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow() override;
 
 private slots:
     void on_addBookButton_clicked();
-    void on_bookListWidget_itemDoubleClicked(QListWidgetItem* item);
+    void on_bookListView_doubleClicked(const QModelIndex &index);
     void on_removeBookButton_clicked();
     void on_addCopiesButton_clicked();
     void on_addClientButton_clicked();
     void on_familyListWidget_doubleClicked(const QModelIndex &index);
     void on_clientListWidget_doubleClicked(const QModelIndex &index);
-    void onBooksUpdated();
-    void onloadBorrowRecords();
+    void on_clientResultsWidget_doubleClicked(const QModelIndex &index);
+    void on_bookSearchEdit_textChanged(const QString &text);
+    void on_clientSearchEdit_textChanged(const QString &text);
+    void runBookSearch();
 
 
 private:
     Ui::MainWindow *ui{};
     Library* _library{};
+    BookListModel* _bookModel{};
+    QHash<int, QListWidgetItem*> _clientItems; // client id -> its row in clientListWidget
+    QHash<int, QListWidgetItem*> _resultItems; // client id -> its row in clientResultsWidget
+    QTimer _searchTimer; // Batches keystrokes into one query
+    static constexpr int SearchResultLimit = 200;
+    static constexpr int ClientResultLimit = 50;
 
-    void updateBookList() const;
     void updateClientList();
+    void updateClient(int clientId);
+    static void addClientItem(QListWidget* list, QHash<int, QListWidgetItem*>& items, const Client& client);
+    static void removeClientItem(QListWidget* list, QHash<int, QListWidgetItem*>& items, int clientId);
+    // Row in Library::allBooks() of the selected book, or -1
+    int selectedBookRow() const;
     void updateFamilyList();
 };
 
@@ -0,0 +1,76 @@
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#include <atomic>
+#include <utility>
+
+/**
+ * @class MpscQueue
+ * @brief Unbounded lock-free queue for many producers and a single consumer.
+ *
+ * A push is one atomic exchange plus one store, so producers never wait on
+ * each other or on the consumer. The consumer owns the tail and is the only
+ * thread allowed to call tryPop(). tryPop() may briefly report the queue as
+ * empty while a push is half done (between its exchange and its link); a
+ * consumer that knows an item is coming should simply try again.
+ *
+ * T must be default constructible and movable.
+ */
+template<typename T>
+class MpscQueue
+{
+public:
+    MpscQueue()
+        : m_tail(new Node)
+    {
+        m_head.store(m_tail, std::memory_order_relaxed);
+    }
+
+    ~MpscQueue()
+    {
+        while (m_tail) {
+            Node* next = m_tail->next.load(std::memory_order_relaxed);
+            delete m_tail;
+            m_tail = next;
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Safe from any thread
+    void push(T value)
+    {
+        Node* node = new Node(std::move(value));
+        Node* previous = m_head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    // Consumer thread only
+    bool tryPop(T& value)
+    {
+        Node* tail = m_tail;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) {
+            return false;
+        }
+        // `next` becomes the new empty stub once its value is moved out
+        value = std::move(next->value);
+        m_tail = next;
+        delete tail;
+        return true;
+    }
+
+private:
+    struct Node {
+        Node() = default;
+        explicit Node(T v) : value(std::move(v)) {}
+        std::atomic<Node*> next = nullptr;
+        T value{};
+    };
+
+    std::atomic<Node*> m_head; // last pushed node, swapped by producers
+    Node* m_tail;              // stub in front of the oldest item, consumer only
+};
+
+#endif // MPSCQUEUE_H
@@ -0,0 +1,85 @@
+#ifndef QUERYMETRICS_H
+#define QUERYMETRICS_H
+
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVariantList>
+#include <array>
+#include <atomic>
+#include <memory>
+
+// Latency aggregate for one kind of statement, e.g. "SELECT borrow_records"
+struct QueryStats {
+    // Log-scale buckets: four per power of two, starting at 1 microsecond
+    static constexpr int BucketCount = 104;
+
+    QString label;
+    quint64 count = 0;
+    qint64 totalNs = 0;
+    qint64 maxNs = 0;
+    std::array<quint64, BucketCount> histogram{};
+
+    [[nodiscard]] qint64 percentileNs(double percentile) const;
+    [[nodiscard]] qint64 averageNs() const { return count ? totalNs / static_cast<qint64>(count) : 0; }
+    void merge(const QueryStats& other);
+};
+
+/**
+ * @class QueryMetrics
+ * @brief Process-wide latency statistics for every statement DbManager runs.
+ *
+ * Shared by all connections (GUI thread and workers) and safe to call from
+ * any thread. Each thread counts into a shard of its own, so record() never
+ * waits on another thread; snapshot() merges the shards. Statements slower
+ * than the threshold are written to the slow query log together with their
+ * bound values, under a lock of its own.
+ */
+class QueryMetrics
+{
+public:
+    static QueryMetrics& instance()
+    {
+        static QueryMetrics instance;
+        return instance;
+    }
+
+    void record(const QString& label, qint64 elapsedNs);
+    // Callers check isSlow() first, so fast statements never build their SQL
+    // text and bound values just to be dropped
+    [[nodiscard]] bool isSlow(const qint64 elapsedNs) const
+    {
+        return elapsedNs >= m_slowThresholdNs.load(std::memory_order_relaxed);
+    }
+    void recordSlow(const QString& label, qint64 elapsedNs, const QString& sql, const QVariantList& boundValues);
+
+    void setSlowQueryThresholdMs(int thresholdMs);
+    // Empty path sends slow queries to the debug log only
+    void setSlowQueryLogPath(const QString& path);
+
+    [[nodiscard]] QList<QueryStats> snapshot() const;
+    void reset();
+    // Writes one line per statement kind, slowest total time first
+    void dump() const;
+
+private:
+    // One thread's statistics; its mutex is only contended by snapshot() and reset()
+    struct Shard {
+        QMutex mutex;
+        QHash<QString, QueryStats> stats;
+    };
+
+    QueryMetrics() = default;
+    static int bucketFor(qint64 elapsedNs);
+    Shard& localShard();
+
+    mutable QMutex m_shardsMutex;
+    QList<std::shared_ptr<Shard>> m_shards; // kept after their thread ends
+    std::atomic<qint64> m_slowThresholdNs = 50'000'000;
+    QMutex m_logMutex;
+    QFile m_slowLog;
+};
+
+#endif // QUERYMETRICS_H
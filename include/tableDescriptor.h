@@ -0,0 +1,144 @@
+#ifndef TABLEDESCRIPTOR_H
+#define TABLEDESCRIPTOR_H
+
+#include <QDate>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QString>
+#include <QVariant>
+#include <array>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "dbManager.h"
+
+// A table column: its name in SQL and the member of the row struct it fills
+template<typename Row, typename Field>
+struct Column {
+    const char* name;
+    Field Row::*member;
+};
+
+template<typename Row, typename Field>
+constexpr Column<Row, Field> column(const char* name, Field Row::*member)
+{
+    return {name, member};
+}
+
+/**
+ * @struct TableDescriptor
+ * @brief Compile-time description of a table, specialised per schema struct.
+ *
+ * `columns` is a tuple of Column entries, so every column keeps its own C++
+ * type and RowDecoder can convert each cell without a runtime switch.
+ */
+template<typename Row>
+struct TableDescriptor;
+
+template<>
+struct TableDescriptor<BookSchema> {
+    static constexpr DbTable table = DbTable::Books;
+    static constexpr auto columns = std::make_tuple(
+        column("id", &BookSchema::id),
+        column("title", &BookSchema::title),
+        column("author", &BookSchema::author),
+        column("year", &BookSchema::year),
+        column("copies", &BookSchema::copies),
+        column("borrowed_count", &BookSchema::borrowed_count));
+};
+
+template<>
+struct TableDescriptor<ClientSchema> {
+    static constexpr DbTable table = DbTable::Clients;
+    static constexpr auto columns = std::make_tuple(
+        column("id", &ClientSchema::id),
+        column("name", &ClientSchema::name),
+        column("surname", &ClientSchema::surname),
+        column("family", &ClientSchema::family));
+};
+
+template<>
+struct TableDescriptor<FamilySchema> {
+    static constexpr DbTable table = DbTable::Families;
+    static constexpr auto columns = std::make_tuple(
+        column("name", &FamilySchema::name));
+};
+
+template<>
+struct TableDescriptor<BorrowRecordSchema> {
+    static constexpr DbTable table = DbTable::BorrowRecords;
+    static constexpr auto columns = std::make_tuple(
+        column("id", &BorrowRecordSchema::id),
+        column("book_id", &BorrowRecordSchema::book_id),
+        column("client_id", &BorrowRecordSchema::client_id),
+        column("borrow_date", &BorrowRecordSchema::borrow_date),
+        column("return_date", &BorrowRecordSchema::return_date),
+        column("is_returned", &BorrowRecordSchema::is_returned));
+};
+
+/**
+ * @class RowDecoder
+ * @brief Fills schema structs from a result set by column position.
+ *
+ * The position of every descriptor column is looked up in the query's record
+ * once, when the decoder is built after exec(); decode() then reads each
+ * cell by index and converts it to the member's type. A column missing from
+ * the result set leaves its member default-initialised.
+ */
+template<typename Row>
+class RowDecoder
+{
+public:
+    static constexpr std::size_t ColumnCount = std::tuple_size_v<decltype(TableDescriptor<Row>::columns)>;
+
+    explicit RowDecoder(const QSqlQuery& query)
+    {
+        const QSqlRecord record = query.record();
+        resolve(record, std::make_index_sequence<ColumnCount>{});
+    }
+
+    // The row the query is positioned on
+    [[nodiscard]] Row decode(const QSqlQuery& query) const
+    {
+        Row row{};
+        fill(row, query, std::make_index_sequence<ColumnCount>{});
+        return row;
+    }
+
+private:
+    template<std::size_t... I>
+    void resolve(const QSqlRecord& record, std::index_sequence<I...>)
+    {
+        ((m_positions[I] = record.indexOf(QLatin1String(std::get<I>(TableDescriptor<Row>::columns).name))), ...);
+    }
+
+    template<std::size_t... I>
+    void fill(Row& row, const QSqlQuery& query, std::index_sequence<I...>) const
+    {
+        (assign(row, std::get<I>(TableDescriptor<Row>::columns), query, m_positions[I]), ...);
+    }
+
+    template<typename Field>
+    static void assign(Row& row, const Column<Row, Field>& column, const QSqlQuery& query, const int position)
+    {
+        if (position < 0) {
+            return;
+        }
+        const QVariant value = query.value(position);
+        if constexpr (std::is_same_v<Field, int>) {
+            row.*column.member = value.toInt();
+        } else if constexpr (std::is_same_v<Field, bool>) {
+            row.*column.member = value.toBool();
+        } else if constexpr (std::is_same_v<Field, QString>) {
+            row.*column.member = value.toString();
+        } else if constexpr (std::is_same_v<Field, QDate>) {
+            row.*column.member = value.toDate();
+        } else {
+            static_assert(!sizeof(Field), "RowDecoder has no conversion for this column type");
+        }
+    }
+
+    std::array<int, ColumnCount> m_positions{};
+};
+
+#endif // TABLEDESCRIPTOR_H
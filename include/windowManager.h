@@ -5,6 +5,7 @@
 #ifndef WINDOWMANAGER_H
 #define WINDOWMANAGER_H
 #include <qobject.h>
+#include <QSet>
 
 #include "mainWindow.h"
 #include "windows/abstractWindow.h"
@@ -23,12 +24,19 @@ public:
 
     int startNewWindow(AbstractWindow* window);
     void setMainWindow(MainWindow* mainWindow);
-    void handleEvent(EventType event);
+    // Queues a change for the open windows and the main window. Everything
+    // posted before control returns to the event loop is delivered as one
+    // batch, with repeated changes dropped.
+    void postEvent(const ChangeEvent& event);
 private:
+        void deliverPendingEvents();
         WindowManager();
         QList<AbstractWindow*> m_windows;
         void onWindowClosed(AbstractWindow* window);
-        MainWindow* m_mainWindow;
+        MainWindow* m_mainWindow = nullptr;
+        ChangeBatch m_pendingEvents;
+        QSet<ChangeEvent> m_pendingSet;
+        bool m_deliveryScheduled = false;
 };
 
 
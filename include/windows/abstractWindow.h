@@ -5,15 +5,16 @@
 #ifndef ABSTRACTWINDOW_H
 #define ABSTRACTWINDOW_H
 #include <QDialog>
+#include <QList>
+#include "../changeEvent.h"
 
 
-enum class EventType {
-    None,
-    BooksUpdated,
-    ClientsUpdated,
-    FamiliesUpdated,
-    TransactionsUpdated
-};
+/**
+ * Windows receive the changes Library published since the last delivery,
+ * in order and with duplicates removed. A CatalogReloaded entry means
+ * the whole catalog was replaced and the window should rebuild.
+ */
+using ChangeBatch = QList<ChangeEvent>;
 
 /**
  * @class AbstractWindow
@@ -34,11 +35,11 @@ public:
 
     /**
      * @brief A pure virtual function to handle events.
-     * @param event The type of event to handle, from the EventType enum.
+     * @param changes The changes since the last delivery, from the event loop.
      *
      * Subclasses must provide an implementation for this function.
      */
-    virtual void handleEvent(EventType event) = 0;
+    virtual void handleEvent(const ChangeBatch& changes) = 0;
 };
 
 
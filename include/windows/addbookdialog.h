@@ -20,7 +20,7 @@ class AddBookDialog final :public AbstractWindow
 public:
     explicit AddBookDialog(QWidget *parent = nullptr);
     ~AddBookDialog() override;
-    void handleEvent(EventType event) override;
+    void handleEvent(const ChangeBatch& changes) override;
     QString getTitle() const;
     QString getAuthor() const;
     int getYear() const;
@@ -23,7 +23,7 @@ public:
     QString getName() const;
     QString getSurname() const;
     QString getFamily() const;
-    void handleEvent(EventType event) override;
+    void handleEvent(const ChangeBatch& changes) override;
 
 private:
     Ui::AddClientDialog *ui;
@@ -7,6 +7,7 @@
 #include "../book.h"
 #include "../library.h"
 
+class QTableWidget;
 class QTableWidgetItem;
 
 namespace Ui {
@@ -20,23 +21,39 @@ class BookDetailDialog : public AbstractWindow
 public:
     explicit BookDetailDialog(const Book& book, Library* library, QWidget *parent = nullptr);
     ~BookDetailDialog() override;
-    void handleEvent(EventType event) override;
+    void handleEvent(const ChangeBatch& changes) override;
 
 private:
     void setupUI();
     void loadBorrowRecords();
     void updateTables();
     void onBooksUpdated();
+    // Row-level updates driven by change events
+    void appendRecordRow(const BorrowRecordWithClient& entry);
+    void fillCurrentRow(int row, const BorrowRecordWithClient& entry);
+    void fillHistoryRow(int row, const BorrowRecordWithClient& entry);
+    void updateRecord(const ChangeEvent& change);
+    void updateClientName(int clientId);
+    static QTableWidgetItem* clientItem(const BorrowRecordWithClient& entry);
+    static int rowOfRecord(const QTableWidget* table, int recordId);
+
+    static constexpr int RecordIdRole = Qt::UserRole + 1;
 
 private:
     Ui::BookDetailDialog *ui;
     Book m_book;
     Library* m_library;
-    QList<BorrowRecord> m_borrowRecords;
+    QList<BorrowRecordWithClient> m_borrowRecords;
+    // Only the newest load may fill the tables; records and clients changed
+    // while it runs are re-read once it lands
+    int m_loadGeneration = 0;
+    bool m_loading = false;
+    QList<ChangeEvent> m_pendingRecordChanges;
+    QList<int> m_pendingClientIds;
+    void openClient(const QTableWidgetItem* item);
 private slots:
     void onTableDoubleClicked(int row, int column);
     void onTableItemDoubleClicked(QTableWidgetItem *item);
-    void onloadBorrowRecords();
 };
 
 #endif // BOOKDETAILDIALOG_H
@@ -28,7 +28,7 @@ class ClientDetailDialog : public AbstractWindow
 public:
     explicit ClientDetailDialog(const Client& client, Library* library, QWidget *parent = nullptr);
     ~ClientDetailDialog() override;
-    void handleEvent(EventType event) override;
+    void handleEvent(const ChangeBatch& changes) override;
 public slots:
     void loadBorrowRecords();
 
@@ -45,10 +45,19 @@ private slots:
 private:
     Ui::ClientDetailDialog *ui;
     Client m_client;
-    QVector<BorrowRecord> m_borrowRecords;
+    QList<BorrowRecordWithBook> m_borrowRecords;
     Library* m_library = Library::instance();
+    // Only the newest load may fill the table; records changed while it runs
+    // are re-read once it lands, so its older rows cannot undo them
+    int m_loadGeneration = 0;
+    bool m_loading = false;
+    QList<ChangeEvent> m_pendingRecordChanges;
     void setupUI();
     void updateBorrowTable();
+    // Renders m_borrowRecords[row] into the same row of the table
+    void setBorrowRow(int row);
+    // Re-reads one record after a change event and updates or appends its row
+    void updateRecord(const ChangeEvent& change);
 };
 
 #endif // CLIENTDETAILDIALOG_H
@@ -19,7 +19,7 @@ class EditClientDialog : public AbstractWindow
 public:
     explicit EditClientDialog(const Client& client, const QList<QString>& existingFamilies, QWidget *parent = nullptr);
     ~EditClientDialog() override;
-    void handleEvent(EventType event) override;
+    void handleEvent(const ChangeBatch& changes) override;
     QString getName() const;
     QString getSurname() const;
     QString getFamily() const;
@@ -17,7 +17,7 @@ class FamilyViewDialog : public AbstractWindow
 
 public:
     explicit FamilyViewDialog(QWidget *parent = nullptr);
-    void handleEvent(EventType event) override;
+    void handleEvent(const ChangeBatch& changes) override;
     ~FamilyViewDialog() override;
 
     void setFamilyInfo(const QString& familyName, const QList<Client>& clients);
@@ -28,6 +28,9 @@ private slots:
 private:
     Ui::FamilyViewDialog *ui{};
     QList<Client> m_clients;
+    QString m_familyName;
+    // Re-reads one client and adds, updates or drops its row
+    void updateClient(int clientId);
 };
 
 #endif // FAMILYVIEWDIALOG_H
@@ -24,7 +24,7 @@ public:
     explicit NewBorrowDialog(const QList<Book>& availableBooks, QWidget *parent = nullptr);
     ~NewBorrowDialog() override;
     void populateBookList();
-    void handleEvent(EventType event) override;
+    void handleEvent(const ChangeBatch& changes) override;
 
     Book getSelectedBook() const;
     QDate getReturnDate() const;
@@ -36,6 +36,9 @@ private slots:
 private:
     Ui::NewBorrowDialog *ui;
     QList<Book> m_availableBooks;
+    // Re-reads one book and adds, updates or drops its row
+    void updateBook(int bookId);
+    static QString bookText(const Book& book);
 };
 
 #endif // NEWBORROWDIALOG_H
\ No newline at end of file
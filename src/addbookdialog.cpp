@@ -13,9 +13,9 @@ AddBookDialog::~AddBookDialog()
     delete ui;
 }
 
-void AddBookDialog::handleEvent(const EventType event)
+void AddBookDialog::handleEvent(const ChangeBatch& changes)
 {
-    Q_UNUSED(event);
+    Q_UNUSED(changes);
     // This dialog does not need to handle any events currently.
 }
 
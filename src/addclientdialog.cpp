@@ -33,7 +33,7 @@ QString AddClientDialog::getFamily() const {
     return ui->familyComboBox->currentText();
 }
 
-void AddClientDialog::handleEvent(const EventType event)
+void AddClientDialog::handleEvent(const ChangeBatch& changes)
 {
-    Q_UNUSED(event);
+    Q_UNUSED(changes);
 }
@@ -0,0 +1,113 @@
+#include "bookListModel.h"
+
+BookListModel::BookListModel(Library* library, QObject* parent)
+    : QAbstractListModel(parent)
+    , m_library(library)
+    , m_rowCount(library->bookCount())
+{
+    connect(m_library, &Library::bookInserted, this, &BookListModel::onBookInserted);
+    connect(m_library, &Library::bookRemoved, this, &BookListModel::onBookRemoved);
+    connect(m_library, &Library::bookChanged, this, &BookListModel::onBookChanged);
+    connect(m_library, &Library::booksUpdated, this, &BookListModel::onBooksUpdated);
+}
+
+int BookListModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_filtered ? static_cast<int>(m_filterIds.size()) : m_rowCount;
+}
+
+int BookListModel::libraryRow(const int row) const
+{
+    if (!m_filtered) {
+        return row;
+    }
+    return row < m_filterIds.size() ? m_library->bookRow(m_filterIds.at(row)) : -1;
+}
+
+QVariant BookListModel::data(const QModelIndex& index, int role) const
+{
+    const int row = index.isValid() ? libraryRow(index.row()) : -1;
+    // A filtered book may have been removed since the filter was set
+    const std::optional<Book> book = m_library->bookAt(row);
+    if (!book) {
+        return {};
+    }
+    switch (role) {
+    case Qt::DisplayRole:
+        return book->toString();
+    case BookIdRole:
+        return book->id();
+    default:
+        return {};
+    }
+}
+
+void BookListModel::setFilter(const QList<int>& bookIds)
+{
+    beginResetModel();
+    m_filtered = true;
+    m_filterIds = bookIds;
+    m_filterRows.clear();
+    m_filterRows.reserve(bookIds.size());
+    for (int row = 0; row < bookIds.size(); ++row) {
+        m_filterRows.insert(bookIds.at(row), row);
+    }
+    endResetModel();
+}
+
+void BookListModel::clearFilter()
+{
+    if (!m_filtered) {
+        return;
+    }
+    beginResetModel();
+    m_filtered = false;
+    m_filterIds.clear();
+    m_filterRows.clear();
+    m_rowCount = m_library->bookCount();
+    endResetModel();
+}
+
+void BookListModel::onBookInserted(const int row)
+{
+    if (m_filtered) {
+        return;
+    }
+    beginInsertRows(QModelIndex(), row, row);
+    ++m_rowCount;
+    endInsertRows();
+}
+
+void BookListModel::onBookRemoved(const int row)
+{
+    if (m_filtered) {
+        return;
+    }
+    beginRemoveRows(QModelIndex(), row, row);
+    --m_rowCount;
+    endRemoveRows();
+}
+
+void BookListModel::onBookChanged(int row)
+{
+    if (m_filtered) {
+        const std::optional<Book> book = m_library->bookAt(row);
+        row = book ? m_filterRows.value(book->id(), -1) : -1;
+    }
+    if (row < 0 || row >= rowCount()) {
+        return;
+    }
+    const QModelIndex changed = index(row);
+    emit dataChanged(changed, changed, {Qt::DisplayRole});
+}
+
+void BookListModel::onBooksUpdated()
+{
+    // A filter keeps its ids; rows whose book is gone render empty until it is reapplied
+    beginResetModel();
+    m_rowCount = m_library->bookCount();
+    endResetModel();
+}
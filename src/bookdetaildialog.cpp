@@ -1,6 +1,9 @@
 #include "windows/bookdetaildialog.h"
 #include "../ui/ui_bookdetaildialog.h"
 #include <QDate>
+#include <QFutureWatcher>
+#include <algorithm>
+#include <utility>
 
 
 #include "windowManager.h"
@@ -15,7 +18,6 @@ BookDetailDialog::BookDetailDialog(const Book& book, Library* library, QWidget *
     ui->setupUi(this);
     setupUI();
     loadBorrowRecords();
-    updateTables();
     connect(ui->currentBorrowsTable, &QTableWidget::cellDoubleClicked, this, &BookDetailDialog::onTableDoubleClicked);
     // For item pointer version:
     connect(ui->historyTable, &QTableWidget::itemDoubleClicked, this, &BookDetailDialog::onTableItemDoubleClicked);
@@ -28,9 +30,30 @@ BookDetailDialog::~BookDetailDialog()
     delete ui;
 }
 
-void BookDetailDialog::handleEvent(const EventType event)
+void BookDetailDialog::handleEvent(const ChangeBatch& changes)
 {
-    onBooksUpdated();
+    for (const ChangeEvent& change : changes) {
+        if (change.kind == ChangeEvent::Kind::CatalogReloaded) {
+            onBooksUpdated();
+            loadBorrowRecords();
+        } else if (change.kind == ChangeEvent::Kind::ClientEdited) {
+            if (!m_loading) {
+                updateClientName(change.clientId);
+            } else if (!m_pendingClientIds.contains(change.clientId)) {
+                m_pendingClientIds.append(change.clientId);
+            }
+        } else if (change.bookId == m_book.id()) {
+            onBooksUpdated();
+            if (!change.isBorrow()) {
+                continue;
+            }
+            if (!m_loading) {
+                updateRecord(change);
+            } else {
+                m_pendingRecordChanges.append(change);
+            }
+        }
+    }
 }
 
 void BookDetailDialog::setupUI()
@@ -62,8 +85,30 @@ void BookDetailDialog::setupUI()
 
 void BookDetailDialog::loadBorrowRecords()
 {
-    m_borrowRecords.clear();
-    m_borrowRecords = m_library->getBorrowRecordsByBookId(m_book.id());
+    // The query runs on the database worker; the tables are rebuilt once the records arrive.
+    // Changes committed before this point are in its result.
+    const int generation = ++m_loadGeneration;
+    m_loading = true;
+    m_pendingRecordChanges.clear();
+    m_pendingClientIds.clear();
+    auto* watcher = new QFutureWatcher<QList<BorrowRecordWithClient>>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, generation]() {
+        watcher->deleteLater();
+        if (generation != m_loadGeneration) {
+            return; // A newer load was started after this one
+        }
+        m_borrowRecords = watcher->result();
+        m_loading = false;
+        updateTables();
+        // Replayed in commit order, so the last change to a record wins
+        for (const ChangeEvent& change : std::exchange(m_pendingRecordChanges, {})) {
+            updateRecord(change);
+        }
+        for (const int clientId : std::exchange(m_pendingClientIds, {})) {
+            updateClientName(clientId);
+        }
+    });
+    watcher->setFuture(m_library->getBookBorrowHistoryAsync(m_book.id()));
 }
 
 void BookDetailDialog::updateTables()
@@ -73,96 +118,166 @@ void BookDetailDialog::updateTables()
     ui->historyTable->clearContents();
     ui->historyTable->setRowCount(0);
 
-    for (const auto& record : m_borrowRecords) {
-        Client client = m_library->getClientById(record.clientId);
-        QString clientName = QString("%1 %2").arg(client.name(), client.surname());
+    for (const auto& entry : m_borrowRecords) {
+        appendRecordRow(entry);
+    }
+}
 
-        if (record.isReturned) {
-            // Populate history table
-            const int row = ui->historyTable->rowCount();
-            ui->historyTable->insertRow(row);
+void BookDetailDialog::appendRecordRow(const BorrowRecordWithClient& entry)
+{
+    QTableWidget* table = entry.record.isReturned ? ui->historyTable : ui->currentBorrowsTable;
+    const int row = table->rowCount();
+    table->insertRow(row);
+    if (entry.record.isReturned) {
+        fillHistoryRow(row, entry);
+    } else {
+        fillCurrentRow(row, entry);
+    }
+}
 
-            QDate actualReturnDate = record.returnDate; // Assuming returnDate is the actual return date when isReturned is true.
-            int daysLate = 0;
-            QDate expectedReturnDate = record.returnDate;
-            if (actualReturnDate > expectedReturnDate) {
-                daysLate = expectedReturnDate.daysTo(actualReturnDate);
-            }
+void BookDetailDialog::fillCurrentRow(const int row, const BorrowRecordWithClient& entry)
+{
+    const BorrowRecord& record = entry.record;
+    bool isLate = QDate::currentDate() > record.returnDate;
+    QTableWidgetItem* isLateItem = new QTableWidgetItem(isLate ? "Yes" : "No");
+    if (isLate) {
+        isLateItem->setForeground(QBrush(QColor("red")));
+    }
+
+    ui->currentBorrowsTable->setItem(row, 0, clientItem(entry));
+    ui->currentBorrowsTable->setItem(row, 1, new QTableWidgetItem(record.borrowDate.toString("dd/MM/yyyy")));
+    ui->currentBorrowsTable->setItem(row, 2, new QTableWidgetItem(record.returnDate.toString("dd/MM/yyyy")));
+    ui->currentBorrowsTable->setItem(row, 3, isLateItem);
+}
+
+void BookDetailDialog::fillHistoryRow(const int row, const BorrowRecordWithClient& entry)
+{
+    const BorrowRecord& record = entry.record;
+    QDate actualReturnDate = record.returnDate; // Assuming returnDate is the actual return date when isReturned is true.
+    int daysLate = 0;
+    QDate expectedReturnDate = record.returnDate;
+    if (actualReturnDate > expectedReturnDate) {
+        daysLate = expectedReturnDate.daysTo(actualReturnDate);
+    }
+
+    ui->historyTable->setItem(row, 0, clientItem(entry));
+    ui->historyTable->setItem(row, 1, new QTableWidgetItem(record.borrowDate.toString("dd/MM/yyyy")));
+    ui->historyTable->setItem(row, 2, new QTableWidgetItem(expectedReturnDate.toString("dd/MM/yyyy")));
+    ui->historyTable->setItem(row, 3, new QTableWidgetItem(actualReturnDate.toString("dd/MM/yyyy")));
+    ui->historyTable->setItem(row, 4, new QTableWidgetItem(QString::number(daysLate)));
+}
+
+QTableWidgetItem* BookDetailDialog::clientItem(const BorrowRecordWithClient& entry)
+{
+    // The client id rides on the name cell so double-click can open the client
+    // directly; the record id lets change events find the row again
+    auto* item = new QTableWidgetItem(QString("%1 %2").arg(entry.clientName, entry.clientSurname));
+    item->setData(Qt::UserRole, entry.record.clientId);
+    item->setData(RecordIdRole, entry.record.id);
+    return item;
+}
+
+int BookDetailDialog::rowOfRecord(const QTableWidget* table, const int recordId)
+{
+    for (int row = 0; row < table->rowCount(); ++row) {
+        if (const QTableWidgetItem* item = table->item(row, 0); item && item->data(RecordIdRole).toInt() == recordId) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+void BookDetailDialog::updateRecord(const ChangeEvent& change)
+{
+    // The event carries the committed record and the client comes from the
+    // in-memory catalog, so nothing here touches the database
+    const int recordId = change.recordId;
+    const BorrowRecord record{recordId, change.bookId, change.clientId,
+                              change.borrowDate, change.returnDate, change.isReturned};
+    const Client client = m_library->getClientById(record.clientId);
+    const BorrowRecordWithClient entry{record, client.name(), client.surname()};
+
+    auto it = std::find_if(m_borrowRecords.begin(), m_borrowRecords.end(),
+                           [recordId](const BorrowRecordWithClient& e) { return e.record.id == recordId; });
+    if (it == m_borrowRecords.end()) {
+        m_borrowRecords.append(entry);
+    } else {
+        *it = entry;
+    }
 
-            ui->historyTable->setItem(row, 0, new QTableWidgetItem(clientName));
-            ui->historyTable->setItem(row, 1, new QTableWidgetItem(record.borrowDate.toString("dd/MM/yyyy")));
-            ui->historyTable->setItem(row, 2, new QTableWidgetItem(expectedReturnDate.toString("dd/MM/yyyy")));
-            ui->historyTable->setItem(row, 3, new QTableWidgetItem(actualReturnDate.toString("dd/MM/yyyy")));
-            ui->historyTable->setItem(row, 4, new QTableWidgetItem(QString::number(daysLate)));
+    const int currentRow = rowOfRecord(ui->currentBorrowsTable, recordId);
+    if (!record.isReturned) {
+        if (currentRow >= 0) {
+            fillCurrentRow(currentRow, entry);
         } else {
-            // Populate current borrows table
-            const int row = ui->currentBorrowsTable->rowCount();
-            ui->currentBorrowsTable->insertRow(row);
-
-            bool isLate = QDate::currentDate() > record.returnDate;
-            QTableWidgetItem* isLateItem = new QTableWidgetItem(isLate ? "Yes" : "No");
-            if (isLate) {
-                isLateItem->setForeground(QBrush(QColor("red")));
-            }
+            appendRecordRow(entry);
+        }
+        return;
+    }
+    // Returned: the row moves from the current borrows to the history
+    if (currentRow >= 0) {
+        ui->currentBorrowsTable->removeRow(currentRow);
+    }
+    if (const int historyRow = rowOfRecord(ui->historyTable, recordId); historyRow >= 0) {
+        fillHistoryRow(historyRow, entry);
+    } else {
+        appendRecordRow(entry);
+    }
+}
 
-            ui->currentBorrowsTable->setItem(row, 0, new QTableWidgetItem(clientName));
-            ui->currentBorrowsTable->setItem(row, 1, new QTableWidgetItem(record.borrowDate.toString("dd/MM/yyyy")));
-            ui->currentBorrowsTable->setItem(row, 2, new QTableWidgetItem(record.returnDate.toString("dd/MM/yyyy")));
-            ui->currentBorrowsTable->setItem(row, 3, isLateItem);
+void BookDetailDialog::updateClientName(const int clientId)
+{
+    const Client client = m_library->getClientById(clientId);
+    if (client.id() < 0) {
+        return;
+    }
+    const QString name = QString("%1 %2").arg(client.name(), client.surname());
+    for (BorrowRecordWithClient& entry : m_borrowRecords) {
+        if (entry.record.clientId == clientId) {
+            entry.clientName = client.name();
+            entry.clientSurname = client.surname();
+        }
+    }
+    for (QTableWidget* table : {ui->currentBorrowsTable, ui->historyTable}) {
+        for (int row = 0; row < table->rowCount(); ++row) {
+            if (QTableWidgetItem* item = table->item(row, 0); item && item->data(Qt::UserRole).toInt() == clientId) {
+                item->setText(name);
+            }
         }
     }
 }
 
 void BookDetailDialog::onBooksUpdated()
 {
-    updateTables();
+    // Copies or borrowed count changed; the borrow records arrive as their own event
+    const std::optional<Book> book = m_library->getBookById(m_book.id());
+    if (!book) {
+        return;
+    }
+    m_book = *book;
+    ui->totalCopiesLabel->setText(QString::number(m_book.copies()));
+    ui->availableCopiesLabel->setText(QString::number(m_book.availableCopies()));
 }
 
 void BookDetailDialog::onTableDoubleClicked(int row, int column)
 {
     if (column != 0) return; // Only respond to client name cell
     if (row < 0 || row >= ui->currentBorrowsTable->rowCount()) return; // Invalid row
-    const QString clientName = ui->currentBorrowsTable->item(row, 0)->text();
-    // Assuming clientName is the full string representation of the client
-    // You'll need to find the actual Client object from the library
-    for (const auto& record : m_borrowRecords)
-    {
-        Client client = m_library->getClientById(record.clientId);
-        QString clientTmpName = QString("%1 %2").arg(client.name(), client.surname());
-        if (clientTmpName == clientName)
-        {
-            ClientDetailDialog dialog(client, m_library, this);
-            WindowManager::instance().startNewWindow(&dialog);
-            return;
-        }
-    }
+    openClient(ui->currentBorrowsTable->item(row, 0));
 }
 
 void BookDetailDialog::onTableItemDoubleClicked(QTableWidgetItem* item)
 {
-    int row = item->row();
-    int column = item->column();
-    if (column != 0) return; // Only respond to client name cell
-    if (row < 0 || row >= ui->historyTable->rowCount()) return; // Invalid row
-    const QString clientName = ui->historyTable->item(row, 0)->text();
-    // Assuming clientName is the full string representation of the client
-    // You'll need to find the actual Client object from the library
-    for (const auto& record : m_borrowRecords)
-    {
-        Client client = m_library->getClientById(record.clientId);
-        if (QString clientTmpName = QString("%1 %2").arg(client.name(), client.surname()); clientTmpName == clientName)
-        {
-            ClientDetailDialog dialog(client, m_library, this);
-            connect(&dialog, &ClientDetailDialog::loadBorrowRecords, this, &BookDetailDialog::onloadBorrowRecords);
-            WindowManager::instance().startNewWindow(&dialog);
-            return;
-        }
-    }
-
+    if (item->column() != 0) return; // Only respond to client name cell
+    openClient(ui->historyTable->item(item->row(), 0));
 }
 
-void BookDetailDialog::onloadBorrowRecords()
+void BookDetailDialog::openClient(const QTableWidgetItem* item)
 {
-    loadBorrowRecords();
-    updateTables();
+    if (!item) return;
+    const Client client = m_library->getClientById(item->data(Qt::UserRole).toInt());
+    if (client.id() < 0) return; // Client no longer exists
+    // Borrows made from the client dialog reach this one through the event bus
+    ClientDetailDialog dialog(client, m_library, this);
+    WindowManager::instance().startNewWindow(&dialog);
 }
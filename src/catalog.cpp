@@ -0,0 +1,188 @@
+#include "catalog.h"
+
+void Catalog::setBooks(const QList<Book>& books)
+{
+    m_books = ChunkedList<Book>(books);
+    m_bookRows.clear();
+    m_bookRows.reserve(m_books.size());
+    m_bookByTitle.clear();
+    m_bookByTitle.reserve(m_books.size());
+    for (const Book& book : m_books) {
+        m_bookByTitle.insert(titleKey(book.title(), book.author()), book.id());
+    }
+    reindexBooks(0);
+}
+
+void Catalog::setClients(const QList<Client>& clients)
+{
+    m_clients = ChunkedList<Client>(clients);
+    m_clientRows.clear();
+    m_clientRows.reserve(m_clients.size());
+    m_familyMembers.clear();
+    m_clientSearch.clear();
+    for (const Client& client : m_clients) {
+        m_familyMembers[client.family()].append(client.id());
+        m_clientSearch.insert(client);
+    }
+    reindexClients(0);
+}
+
+void Catalog::setFamilies(const QStringList& families)
+{
+    m_families = families;
+}
+
+const Book* Catalog::book(const int id) const
+{
+    const qsizetype row = bookRow(id);
+    return row < 0 ? nullptr : &m_books.at(row);
+}
+
+qsizetype Catalog::bookRow(const int id) const
+{
+    return m_bookRows.value(id, -1);
+}
+
+const Book* Catalog::bookByTitleAndAuthor(const QString& title, const QString& author) const
+{
+    const auto it = m_bookByTitle.constFind(titleKey(title, author));
+    return it == m_bookByTitle.constEnd() ? nullptr : book(it.value());
+}
+
+void Catalog::addBook(const Book& book)
+{
+    m_bookRows.insert(book.id(), m_books.size());
+    m_bookByTitle.insert(titleKey(book.title(), book.author()), book.id());
+    m_books.append(book);
+}
+
+bool Catalog::updateBook(const Book& book)
+{
+    const qsizetype row = bookRow(book.id());
+    if (row < 0) {
+        return false;
+    }
+    if (const Book& old = m_books.at(row); old.title() != book.title() || old.author() != book.author()) {
+        unindexTitle(old);
+        m_bookByTitle.insert(titleKey(book.title(), book.author()), book.id());
+    }
+    m_books.replace(row, book);
+    return true;
+}
+
+bool Catalog::removeBook(const int id)
+{
+    const qsizetype row = bookRow(id);
+    if (row < 0) {
+        return false;
+    }
+    unindexTitle(m_books.at(row));
+    m_books.removeAt(row);
+    m_bookRows.remove(id);
+    reindexBooks(row);
+    return true;
+}
+
+const Client* Catalog::client(const int id) const
+{
+    const qsizetype row = clientRow(id);
+    return row < 0 ? nullptr : &m_clients.at(row);
+}
+
+qsizetype Catalog::clientRow(const int id) const
+{
+    return m_clientRows.value(id, -1);
+}
+
+void Catalog::addClient(const Client& client)
+{
+    m_clientRows.insert(client.id(), m_clients.size());
+    m_clients.append(client);
+    m_familyMembers[client.family()].append(client.id());
+    m_clientSearch.insert(client);
+}
+
+bool Catalog::updateClient(const Client& client)
+{
+    const qsizetype row = clientRow(client.id());
+    if (row < 0) {
+        return false;
+    }
+    if (const QString oldFamily = m_clients.at(row).family(); oldFamily != client.family()) {
+        if (auto it = m_familyMembers.find(oldFamily); it != m_familyMembers.end()) {
+            it->removeOne(client.id());
+            if (it->isEmpty()) {
+                m_familyMembers.erase(it);
+            }
+        }
+        m_familyMembers[client.family()].append(client.id());
+    }
+    m_clients.replace(row, client);
+    m_clientSearch.update(client);
+    return true;
+}
+
+bool Catalog::removeClient(const int id)
+{
+    const qsizetype row = clientRow(id);
+    if (row < 0) {
+        return false;
+    }
+    if (auto it = m_familyMembers.find(m_clients.at(row).family()); it != m_familyMembers.end()) {
+        it->removeOne(id);
+        if (it->isEmpty()) {
+            m_familyMembers.erase(it);
+        }
+    }
+    m_clients.removeAt(row);
+    m_clientRows.remove(id);
+    m_clientSearch.remove(id);
+    reindexClients(row);
+    return true;
+}
+
+void Catalog::addFamily(const QString& family)
+{
+    if (!family.isEmpty() && !hasFamily(family)) {
+        m_families.append(family);
+    }
+}
+
+QList<Client> Catalog::clientsInFamily(const QString& family) const
+{
+    QList<Client> members;
+    for (const int id : m_familyMembers.value(family)) {
+        if (const Client* member = client(id)) {
+            members.append(*member);
+        }
+    }
+    return members;
+}
+
+void Catalog::reindexBooks(const qsizetype from)
+{
+    for (qsizetype row = from; row < m_books.size(); ++row) {
+        m_bookRows.insert(m_books.at(row).id(), row);
+    }
+}
+
+QString Catalog::titleKey(const QString& title, const QString& author)
+{
+    return title + QChar(0x1f) + author;
+}
+
+void Catalog::unindexTitle(const Book& book)
+{
+    // Only drop the entry if it points at this book, not a same-titled one
+    if (const auto it = m_bookByTitle.find(titleKey(book.title(), book.author()));
+        it != m_bookByTitle.end() && it.value() == book.id()) {
+        m_bookByTitle.erase(it);
+    }
+}
+
+void Catalog::reindexClients(const qsizetype from)
+{
+    for (qsizetype row = from; row < m_clients.size(); ++row) {
+        m_clientRows.insert(m_clients.at(row).id(), row);
+    }
+}
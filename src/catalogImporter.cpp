@@ -0,0 +1,241 @@
+#include "catalogImporter.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+
+CatalogImporter::CatalogImporter(const DbManager& dbManager, QObject* parent)
+    : QObject(parent)
+    , m_dbManager(dbManager)
+{
+}
+
+CatalogImporter::Format CatalogImporter::formatForPath(const QString& path)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    return suffix == "jsonl" || suffix == "ndjson" ? Format::JsonLines : Format::Csv;
+}
+
+qint64 CatalogImporter::importFile(const QString& path, const DbTable table)
+{
+    return importFile(path, table, formatForPath(path));
+}
+
+qint64 CatalogImporter::importFile(const QString& path, const DbTable table, const Format format)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qDebug() << "Error opening import file" << path << ":" << file.errorString();
+        return -1;
+    }
+    QTextStream in(&file);
+    m_imported = 0;
+    m_startedMs = QDateTime::currentMSecsSinceEpoch();
+
+    const qint64 result = format == Format::Csv ? importCsv(in, table) : importJsonLines(in, table);
+    const double seconds = qMax<qint64>(1, QDateTime::currentMSecsSinceEpoch() - m_startedMs) / 1000.0;
+    qDebug() << "Imported" << m_imported << "rows from" << path << "in" << seconds << "s"
+             << "(" << m_imported / seconds << "rows/s )";
+    return result;
+}
+
+qint64 CatalogImporter::importCsv(QTextStream& in, const DbTable table)
+{
+    qint64 lineNumber = 0;
+    const QStringList header = readCsvRecord(in, lineNumber);
+    if (header.isEmpty()) {
+        qDebug() << "Import file has no header row.";
+        return -1;
+    }
+    // Like the JSON Lines path, only columns the table has are imported
+    const QVariantMap schema = DbManager::getSchemaForTable(table);
+    QStringList columns;
+    QList<qsizetype> fieldOfColumn;
+    for (qsizetype i = 0; i < header.size(); ++i) {
+        const QString column = header.at(i).trimmed();
+        if (schema.contains(column)) {
+            columns << column;
+            fieldOfColumn << i;
+        } else {
+            qDebug() << "Ignoring unknown import column" << column << "for table" << DbManager::getTableName(table);
+        }
+    }
+    if (columns.isEmpty()) {
+        qDebug() << "Import header names none of the columns of" << DbManager::getTableName(table);
+        return -1;
+    }
+    for (const QString& column : requiredColumns(table)) {
+        if (!columns.contains(column)) {
+            qDebug() << "Import header lacks the required column" << column;
+            return -1;
+        }
+    }
+
+    QList<QVariantList> rows;
+    rows.reserve(m_chunkSize);
+    qint64 skipped = 0;
+    while (!in.atEnd()) {
+        const qint64 recordLine = lineNumber + 1;
+        const QStringList fields = readCsvRecord(in, lineNumber);
+        if (fields.isEmpty() || (fields.size() == 1 && fields.first().isEmpty())) {
+            continue; // blank line
+        }
+        if (fields.size() != header.size()) {
+            qDebug() << "Skipping line" << recordLine << ": it has" << fields.size() << "fields, the header has"
+                     << header.size();
+            ++skipped;
+            continue;
+        }
+        QVariantList row;
+        row.reserve(columns.size());
+        for (const qsizetype field : std::as_const(fieldOfColumn)) {
+            row << fields.at(field);
+        }
+        rows << row;
+        if (rows.size() >= m_chunkSize && !writeChunk(table, columns, rows)) {
+            return -1;
+        }
+    }
+    if (skipped > 0) {
+        qDebug() << "Skipped" << skipped << "malformed rows.";
+    }
+    return writeChunk(table, columns, rows) ? m_imported : -1;
+}
+
+qint64 CatalogImporter::importJsonLines(QTextStream& in, const DbTable table)
+{
+    const QVariantMap schema = DbManager::getSchemaForTable(table);
+    const QStringList required = requiredColumns(table);
+    QStringList columns;
+    QList<QVariantList> rows;
+    rows.reserve(m_chunkSize);
+    qint64 lineNumber = 0;
+    qint64 skipped = 0;
+    while (!in.atEnd()) {
+        const QString line = in.readLine();
+        ++lineNumber;
+        if (line.trimmed().isEmpty()) {
+            continue;
+        }
+        QJsonParseError error{};
+        const QJsonDocument document = QJsonDocument::fromJson(line.toUtf8(), &error);
+        if (error.error != QJsonParseError::NoError || !document.isObject()) {
+            qDebug() << "Skipping line" << lineNumber << ": invalid JSON:" << error.errorString();
+            ++skipped;
+            continue;
+        }
+        const QJsonObject object = document.object();
+        // A row missing a value its INSERT needs would fail the whole chunk
+        const QStringList& needed = columns.isEmpty() ? required : columns;
+        const auto missing = std::find_if(needed.cbegin(), needed.cend(), [&object](const QString& column) {
+            return object.value(column).isNull() || object.value(column).isUndefined();
+        });
+        if (missing != needed.cend()) {
+            qDebug() << "Skipping line" << lineNumber << ": it has no value for" << *missing;
+            ++skipped;
+            continue;
+        }
+        if (columns.isEmpty()) {
+            // The first valid record decides the column set for the whole file
+            for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+                if (schema.contains(it.key())) {
+                    columns << it.key();
+                }
+            }
+        }
+        QVariantList row;
+        row.reserve(columns.size());
+        for (const QString& column : columns) {
+            row << object.value(column).toVariant();
+        }
+        rows << row;
+        if (rows.size() >= m_chunkSize && !writeChunk(table, columns, rows)) {
+            return -1;
+        }
+    }
+    if (skipped > 0) {
+        qDebug() << "Skipped" << skipped << "malformed rows.";
+    }
+    return writeChunk(table, columns, rows) ? m_imported : -1;
+}
+
+QStringList CatalogImporter::requiredColumns(const DbTable table)
+{
+    const QVariantMap schema = DbManager::getSchemaForTable(table);
+    QStringList required;
+    for (auto it = schema.constBegin(); it != schema.constEnd(); ++it) {
+        const QString definition = it.value().toString();
+        if (definition.contains("NOT NULL")
+            || (definition.contains("PRIMARY KEY") && !definition.contains("AUTOINCREMENT"))) {
+            required << it.key();
+        }
+    }
+    return required;
+}
+
+bool CatalogImporter::writeChunk(const DbTable table, const QStringList& columns, QList<QVariantList>& rows)
+{
+    if (rows.isEmpty()) {
+        return true;
+    }
+    DbTransaction transaction(m_dbManager);
+    if (!transaction.isActive() || !m_dbManager.insertRows(table, columns, rows) || !transaction.commit()) {
+        qDebug() << "Import stopped after" << m_imported << "rows.";
+        return false;
+    }
+    m_imported += rows.size();
+    rows.clear();
+
+    const double seconds = qMax<qint64>(1, QDateTime::currentMSecsSinceEpoch() - m_startedMs) / 1000.0;
+    emit progress(m_imported, m_imported / seconds);
+    return true;
+}
+
+QStringList CatalogImporter::readCsvRecord(QTextStream& in, qint64& lineNumber)
+{
+    // RFC 4180: fields may be quoted, quotes are doubled inside quoted
+    // fields, and a quoted field may span several lines.
+    QStringList fields;
+    QString field;
+    bool quoted = false;
+    QString line = in.readLine();
+    if (line.isNull()) {
+        return fields;
+    }
+    ++lineNumber;
+    for (;;) {
+        for (qsizetype i = 0; i < line.size(); ++i) {
+            const QChar c = line.at(i);
+            if (quoted) {
+                if (c == '"') {
+                    if (i + 1 < line.size() && line.at(i + 1) == '"') {
+                        field += '"';
+                        ++i;
+                    } else {
+                        quoted = false;
+                    }
+                } else {
+                    field += c;
+                }
+            } else if (c == '"') {
+                quoted = true;
+            } else if (c == ',') {
+                fields << field;
+                field.clear();
+            } else {
+                field += c;
+            }
+        }
+        if (!quoted || in.atEnd()) {
+            break;
+        }
+        field += '\n';
+        line = in.readLine();
+        ++lineNumber;
+    }
+    fields << field;
+    return fields;
+}
@@ -3,9 +3,11 @@
 #include "windows/newborrowdialog.h"
 #include "windows/editclientdialog.h"
 #include <QApplication>
+#include <QFutureWatcher>
 #include <QInputDialog>
 #include <QStyle>
 #include <QDebug>
+#include <utility>
 
 #include "windowManager.h"
 #include "windows/familyviewdialog.h"
@@ -19,7 +21,6 @@ ClientDetailDialog::ClientDetailDialog(const Client& client, Library* library, Q
     ui->setupUi(this);
     setupUI();
     loadBorrowRecords();
-    updateBorrowTable();
 
     setWindowTitle(QString("Client Details - %1 %2").arg(m_client.name(), m_client.surname()));
     resize(800, 600);
@@ -30,10 +31,24 @@ ClientDetailDialog::~ClientDetailDialog()
     delete ui;
 }
 
-void ClientDetailDialog::handleEvent(EventType event)
+void ClientDetailDialog::handleEvent(const ChangeBatch& changes)
 {
-    loadBorrowRecords();
-    updateBorrowTable();
+    for (const ChangeEvent& change : changes) {
+        if (change.kind == ChangeEvent::Kind::CatalogReloaded) {
+            loadBorrowRecords();
+        } else if (change.clientId != m_client.id()) {
+            continue;
+        } else if (change.isBorrow()) {
+            if (!m_loading) {
+                updateRecord(change);
+            } else {
+                m_pendingRecordChanges.append(change);
+            }
+        } else if (change.kind == ChangeEvent::Kind::ClientEdited) {
+            m_client = m_library->getClientById(m_client.id());
+            setupUI();
+        }
+    }
 }
 
 void ClientDetailDialog::setupUI()
@@ -69,9 +84,26 @@ void ClientDetailDialog::setupUI()
 
 void ClientDetailDialog::loadBorrowRecords()
 {
-    // PROBLEM 1 FIX: Clear the list before loading new records to prevent duplicates.
-    m_borrowRecords.clear();
-    m_borrowRecords = m_library->getBorrowRecordsByClientId(m_client.id());
+    // The query runs on the database worker; the table is rebuilt once the records arrive.
+    // Changes committed before this point are in its result.
+    const int generation = ++m_loadGeneration;
+    m_loading = true;
+    m_pendingRecordChanges.clear();
+    auto* watcher = new QFutureWatcher<QList<BorrowRecordWithBook>>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, generation]() {
+        watcher->deleteLater();
+        if (generation != m_loadGeneration) {
+            return; // A newer load was started after this one
+        }
+        m_borrowRecords = watcher->result();
+        m_loading = false;
+        updateBorrowTable();
+        // Replayed in commit order, so the last change to a record wins
+        for (const ChangeEvent& change : std::exchange(m_pendingRecordChanges, {})) {
+            updateRecord(change);
+        }
+    });
+    watcher->setFuture(m_library->getClientBorrowHistoryAsync(m_client.id()));
 }
 
 void ClientDetailDialog::updateBorrowTable()
@@ -82,48 +114,68 @@ void ClientDetailDialog::updateBorrowTable()
     ui->borrowTable->setRowCount(m_borrowRecords.size());
     
     for (int row = 0; row < m_borrowRecords.size(); ++row) {
-        const BorrowRecord& record = m_borrowRecords.at(row);
-        Book* book = m_library->getBookById(record.bookId);
-        if (!book)
-        {
-            qDebug() << "Could not find book with ID:" << record.bookId;
-            continue; // Skip this record if the book is not found
-        }
-        QString bookTitle = book->title();
-        QString bookAuthor = book->author();
-        // Populate the book information
-        ui->borrowTable->setItem(row, 0, new QTableWidgetItem(bookTitle));
-        ui->borrowTable->setItem(row, 1, new QTableWidgetItem(bookAuthor));
-        ui->borrowTable->setItem(row, 2, new QTableWidgetItem(record.bookId));
-        ui->borrowTable->setItem(row, 3, new QTableWidgetItem(record.borrowDate.toString("dd/MM/yyyy")));
-        ui->borrowTable->setItem(row, 4, new QTableWidgetItem(record.returnDate.toString("dd/MM/yyyy")));
-        
-        // Add status and actions
-        QTableWidgetItem* statusItem = new QTableWidgetItem(record.isReturned ? "Returned" : "Borrowed");
-        ui->borrowTable->setItem(row, 5, statusItem);
+        setBorrowRow(row);
+    }
+}
 
-        QWidget* actionWidget = new QWidget(this);
-        QHBoxLayout* layout = new QHBoxLayout(actionWidget);
-        layout->setContentsMargins(0, 0, 0, 0);
-        layout->setSpacing(5);
+void ClientDetailDialog::setBorrowRow(const int row)
+{
+    // Title and author come joined in with the record, no per-row lookup
+    const BorrowRecordWithBook& entry = m_borrowRecords.at(row);
+    const BorrowRecord& record = entry.record;
+    // Populate the book information
+    ui->borrowTable->setItem(row, 0, new QTableWidgetItem(entry.bookTitle));
+    ui->borrowTable->setItem(row, 1, new QTableWidgetItem(entry.bookAuthor));
+    ui->borrowTable->setItem(row, 2, new QTableWidgetItem(QString::number(record.bookId)));
+    ui->borrowTable->setItem(row, 3, new QTableWidgetItem(record.borrowDate.toString("dd/MM/yyyy")));
+    ui->borrowTable->setItem(row, 4, new QTableWidgetItem(record.returnDate.toString("dd/MM/yyyy")));
+    
+    // Add status and actions
+    QTableWidgetItem* statusItem = new QTableWidgetItem(record.isReturned ? "Returned" : "Borrowed");
+    ui->borrowTable->setItem(row, 5, statusItem);
 
-        if (!record.isReturned) {
-            QPushButton* returnButton = new QPushButton(QApplication::style()->standardIcon(QStyle::SP_DialogYesButton), "Return");
-            returnButton->setToolTip("Return this book");
-            returnButton->setProperty("recordId", record.id);
-            connect(returnButton, &QPushButton::clicked, this, &ClientDetailDialog::on_returnBookButton_clicked);
-            layout->addWidget(returnButton);
+    QWidget* actionWidget = new QWidget(this);
+    QHBoxLayout* layout = new QHBoxLayout(actionWidget);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(5);
 
-            QPushButton* extendButton = new QPushButton(QApplication::style()->standardIcon(QStyle::SP_ArrowRight), "Extend");
-            extendButton->setToolTip("Extend the borrow time");
-            extendButton->setProperty("recordId", record.id);
-            connect(extendButton, &QPushButton::clicked, this, &ClientDetailDialog::on_extendBorrowButton_clicked);
-            layout->addWidget(extendButton);
-        }
+    if (!record.isReturned) {
+        QPushButton* returnButton = new QPushButton(QApplication::style()->standardIcon(QStyle::SP_DialogYesButton), "Return");
+        returnButton->setToolTip("Return this book");
+        returnButton->setProperty("recordId", record.id);
+        connect(returnButton, &QPushButton::clicked, this, &ClientDetailDialog::on_returnBookButton_clicked);
+        layout->addWidget(returnButton);
 
-        actionWidget->setLayout(layout);
-        ui->borrowTable->setCellWidget(row, 6, actionWidget);
+        QPushButton* extendButton = new QPushButton(QApplication::style()->standardIcon(QStyle::SP_ArrowRight), "Extend");
+        extendButton->setToolTip("Extend the borrow time");
+        extendButton->setProperty("recordId", record.id);
+        connect(extendButton, &QPushButton::clicked, this, &ClientDetailDialog::on_extendBorrowButton_clicked);
+        layout->addWidget(extendButton);
     }
+
+    actionWidget->setLayout(layout);
+    ui->borrowTable->setCellWidget(row, 6, actionWidget);
+}
+
+void ClientDetailDialog::updateRecord(const ChangeEvent& change)
+{
+    // The event carries the committed record and the book comes from the
+    // in-memory catalog, so nothing here touches the database
+    const BorrowRecord record{change.recordId, change.bookId, change.clientId,
+                              change.borrowDate, change.returnDate, change.isReturned};
+    const std::optional<Book> book = m_library->getBookById(record.bookId);
+    const BorrowRecordWithBook entry{record, book ? book->title() : QString(), book ? book->author() : QString()};
+
+    for (int row = 0; row < m_borrowRecords.size(); ++row) {
+        if (m_borrowRecords.at(row).record.id == record.id) {
+            m_borrowRecords[row] = entry;
+            setBorrowRow(row);
+            return;
+        }
+    }
+    m_borrowRecords.append(entry);
+    ui->borrowTable->insertRow(ui->borrowTable->rowCount());
+    setBorrowRow(static_cast<int>(m_borrowRecords.size()) - 1);
 }
 
 void ClientDetailDialog::on_newBorrowButton_clicked()
@@ -139,11 +191,8 @@ void ClientDetailDialog::on_newBorrowButton_clicked()
         newRecord.returnDate = newBorrowDialog.getReturnDate(); // Default 2
         newRecord.isReturned = false;
         if  (const TransactionResult result=m_library->borrowBook(m_client.id(), newRecord); result == TransactionResult::Success) {
+            // Library announces the new record; the table picks it up from that event
             QMessageBox::information(this, "Success", "Book borrowed successfully!");
-            // Reload and update the table after a successful borrow
-            loadBorrowRecords();
-            WindowManager::instance().handleEvent(EventType::BooksUpdated);
-            emit updateBorrowTable();
         } else {
             QString errorMsg;
             QString level = "Error";
@@ -203,13 +252,16 @@ void ClientDetailDialog::on_returnBookButton_clicked()
     auto* button = qobject_cast<QPushButton*>(sender());
     if (!button) return;
 
-    if (int recordId = button->property("recordId").toInt(); m_library->returnBook(recordId) == TransactionResult::Success) {
+    const int recordId = button->property("recordId").toInt();
+    if (const TransactionResult result = m_library->returnBook(recordId); result == TransactionResult::Success) {
+        // Library announces the return; the row updates from that event
         QMessageBox::information(this, "Success", "Book returned successfully!");
-        // Reload and update the table after a successful return
-        loadBorrowRecords();
-        emit updateBorrowTable();
+    } else if (result == TransactionResult::Failure_RecordNotFound) {
+        QMessageBox::warning(this, "Error", "This borrow record no longer exists.");
+    } else if (result == TransactionResult::Failure_AlreadyReturned) {
+        QMessageBox::warning(this, "Warning", "This book has already been returned.");
     } else {
-        QMessageBox::warning(this, "Error", "Failed to return book. It may have already been returned.");
+        QMessageBox::warning(this, "Error", "Failed to return book.");
     }
 }
 
@@ -220,46 +272,34 @@ void ClientDetailDialog::on_extendBorrowButton_clicked()
 
     int recordId = button->property("recordId").toInt();
 
-    // Find the book record for context
-    const BorrowRecord* record = nullptr;
-    for (const BorrowRecord r : m_borrowRecords) {
-        if (r.id == recordId) {
-            record = &r;
+    // Find the book record for context. Keep a copy: the records may be
+    // reloaded while the input dialog below runs its own event loop.
+    std::optional<BorrowRecordWithBook> entry;
+    for (const BorrowRecordWithBook& r : m_borrowRecords) {
+        if (r.record.id == recordId) {
+            entry = r;
             break;
         }
     }
 
-    if (!record) {
+    if (!entry) {
         QMessageBox::warning(this, "Error", "Could not find borrow record.");
         return;
     }
-    Book* book = m_library->getBookById(record->bookId);
-    if (!book)
-    {
-        QMessageBox::warning(this, "Error", "Could not find borrow book.");
-        return;
-    }
+    const BorrowRecord* record = &entry->record;
     bool ok;
-    QString bookTitle =book->title();
+    QString bookTitle = entry->bookTitle;
     const int days = QInputDialog::getInt(this, "Extend Borrow Time",
         QString("Extend '%1' by how many days?\n\nCurrent return date: %2")
         .arg(bookTitle, record->returnDate.toString("dd/MM/yyyy")),
         7, 1, 365, 1, &ok);
 
     if (ok) {
+        const QDate newReturnDate = record->returnDate.addDays(days);
         if (m_library->extendBorrowTime(recordId, days)) {
-            loadBorrowRecords();
-            updateBorrowTable();
-
-            // Find updated record to show new date
-            for (const BorrowRecord& r : m_borrowRecords) {
-                if (r.id == recordId) {
-                    QMessageBox::information(this, "Success",
-                        QString("Borrow time extended by %1 days!\n\nNew return date: %2")
-                        .arg(days).arg(r.returnDate.toString("dd/MM/yyyy")));
-                    break;
-                }
-            }
+            QMessageBox::information(this, "Success",
+                QString("Borrow time extended by %1 days!\n\nNew return date: %2")
+                .arg(days).arg(newReturnDate.toString("dd/MM/yyyy")));
         } else {
             QMessageBox::warning(this, "Error", "Failed to extend borrow time.");
         }
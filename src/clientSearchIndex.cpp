@@ -0,0 +1,160 @@
+#include "clientSearchIndex.h"
+#include <QSet>
+#include <algorithm>
+#include <vector>
+
+QList<ClientSearchIndex::Trigram> ClientSearchIndex::trigrams(const QString& text)
+{
+    // Decompose accents and drop the combining marks, then fold case
+    const QString folded = text.normalized(QString::NormalizationForm_KD).toCaseFolded();
+    QString normalized;
+    normalized.reserve(folded.size());
+    for (const QChar c : folded) {
+        if (c.isLetterOrNumber()) {
+            normalized += c;
+        } else if (!c.isMark()) {
+            normalized += QLatin1Char(' ');
+        }
+    }
+
+    QSet<Trigram> seen;
+    QList<Trigram> result;
+    for (const QString& word : normalized.split(QLatin1Char(' '), Qt::SkipEmptyParts)) {
+        const QString padded = QStringLiteral("  ") + word + QLatin1Char(' ');
+        for (qsizetype i = 0; i + 2 < padded.size(); ++i) {
+            const Trigram key = (static_cast<Trigram>(padded.at(i).unicode()) << 32)
+                | (static_cast<Trigram>(padded.at(i + 1).unicode()) << 16)
+                | padded.at(i + 2).unicode();
+            if (!seen.contains(key)) {
+                seen.insert(key);
+                result.append(key);
+            }
+        }
+    }
+    return result;
+}
+
+void ClientSearchIndex::clear()
+{
+    m_clientOfSlot.clear();
+    m_slotOfClient.clear();
+    m_freeSlots.clear();
+    m_slotTrigrams.clear();
+    m_slotPositions.clear();
+    m_postings.clear();
+}
+
+void ClientSearchIndex::insert(const Client& client)
+{
+    if (m_slotOfClient.contains(client.id())) {
+        update(client);
+        return;
+    }
+    int slot;
+    if (m_freeSlots.isEmpty()) {
+        slot = static_cast<int>(m_clientOfSlot.size());
+        m_clientOfSlot.append(client.id());
+        m_slotTrigrams.append({});
+        m_slotPositions.append({});
+    } else {
+        slot = m_freeSlots.takeLast();
+        m_clientOfSlot[slot] = client.id();
+    }
+    m_slotOfClient.insert(client.id(), slot);
+
+    // Family is indexed too, so "cohen" lists the whole household
+    QList<Trigram> grams = trigrams(client.name() + QLatin1Char(' ') + client.surname()
+                                    + QLatin1Char(' ') + client.family());
+    QList<int> positions;
+    positions.reserve(grams.size());
+    for (const Trigram gram : grams) {
+        QList<int>& posting = m_postings[gram];
+        positions.append(static_cast<int>(posting.size()));
+        posting.append(slot);
+    }
+    m_slotTrigrams[slot] = std::move(grams);
+    m_slotPositions[slot] = std::move(positions);
+}
+
+void ClientSearchIndex::remove(const int clientId)
+{
+    const auto it = m_slotOfClient.find(clientId);
+    if (it == m_slotOfClient.end()) {
+        return;
+    }
+    const int slot = it.value();
+    m_slotOfClient.erase(it);
+    const QList<Trigram>& grams = m_slotTrigrams.at(slot);
+    for (qsizetype i = 0; i < grams.size(); ++i) {
+        const auto posting = m_postings.find(grams.at(i));
+        if (posting == m_postings.end()) {
+            continue;
+        }
+        // Move the posting's last slot into our place and tell it where it went
+        const int position = m_slotPositions.at(slot).at(i);
+        const int moved = posting->last();
+        if (moved != slot) {
+            (*posting)[position] = moved;
+            m_slotPositions[moved][m_slotTrigrams.at(moved).indexOf(grams.at(i))] = position;
+        }
+        posting->removeLast();
+        if (posting->isEmpty()) {
+            m_postings.erase(posting);
+        }
+    }
+    m_slotTrigrams[slot].clear();
+    m_slotPositions[slot].clear();
+    m_clientOfSlot[slot] = -1;
+    m_freeSlots.append(slot);
+}
+
+void ClientSearchIndex::update(const Client& client)
+{
+    remove(client.id());
+    insert(client);
+}
+
+QList<ClientSearchIndex::Match> ClientSearchIndex::find(const QString& query, const int limit, const double minScore) const
+{
+    const QList<Trigram> grams = trigrams(query);
+    if (grams.isEmpty() || limit <= 0) {
+        return {};
+    }
+
+    // Per-thread scratch counters, so readers of a shared index never race.
+    // Only the touched counters are reset afterwards, not the whole array.
+    thread_local std::vector<quint16> hits;
+    if (hits.size() < static_cast<size_t>(m_clientOfSlot.size())) {
+        hits.resize(m_clientOfSlot.size(), 0);
+    }
+    QList<int> touched;
+    for (const Trigram gram : grams) {
+        const auto posting = m_postings.constFind(gram);
+        if (posting == m_postings.constEnd()) {
+            continue;
+        }
+        for (const int slot : *posting) {
+            if (hits[slot]++ == 0) {
+                touched.append(slot);
+            }
+        }
+    }
+
+    QList<Match> matches;
+    for (const int slot : std::as_const(touched)) {
+        // Dice coefficient of the two trigram sets
+        const double score = 2.0 * hits[slot]
+            / static_cast<double>(grams.size() + m_slotTrigrams.at(slot).size());
+        if (score >= minScore) {
+            matches.append({m_clientOfSlot.at(slot), score});
+        }
+        hits[slot] = 0;
+    }
+
+    const qsizetype count = std::min<qsizetype>(limit, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + count, matches.end(), [](const Match& a, const Match& b) {
+        return a.score > b.score || (a.score == b.score && a.clientId < b.clientId);
+    });
+    matches.resize(count);
+    return matches;
+}
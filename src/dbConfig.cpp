@@ -0,0 +1,142 @@
+#include "dbConfig.h"
+#include "queryMetrics.h"
+#include <QSettings>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringList>
+#include <QDebug>
+
+namespace {
+
+// PRAGMA values cannot be bound, so anything textual is checked against the
+// values SQLite accepts before it is spliced into the statement.
+QString validated(const QString& value, const QStringList& allowed, const QString& fallback, const char* name)
+{
+    const QString upper = value.trimmed().toUpper();
+    if (allowed.contains(upper)) {
+        return upper;
+    }
+    qDebug() << "Ignoring invalid" << name << "value" << value << "- using" << fallback;
+    return fallback;
+}
+
+QString envOr(const char* name, const QString& fallback)
+{
+    return qEnvironmentVariableIsSet(name) ? qEnvironmentVariable(name) : fallback;
+}
+
+QVariant pragmaValue(const QSqlDatabase& db, const QString& pragma)
+{
+    QSqlQuery query(db);
+    if (!query.exec("PRAGMA " + pragma) || !query.next()) {
+        return {};
+    }
+    return query.value(0);
+}
+
+}
+
+DbConfig DbConfig::load()
+{
+    return load(envOr("LMS_CONFIG", "library.ini"));
+}
+
+DbConfig DbConfig::load(const QString& path)
+{
+    DbConfig config;
+    QSettings settings(path, QSettings::IniFormat);
+    settings.beginGroup("database");
+    QString journalMode = envOr("LMS_JOURNAL_MODE", settings.value("journal_mode", config.journalMode).toString());
+    QString synchronous = envOr("LMS_SYNCHRONOUS", settings.value("synchronous", config.synchronous).toString());
+    QString tempStore = envOr("LMS_TEMP_STORE", settings.value("temp_store", config.tempStore).toString());
+    const QString cacheSize = envOr("LMS_CACHE_SIZE", settings.value("cache_size", config.cacheSize).toString());
+    const QString mmapSize = envOr("LMS_MMAP_SIZE", settings.value("mmap_size", config.mmapSize).toString());
+    const QString busyTimeout = envOr("LMS_BUSY_TIMEOUT", settings.value("busy_timeout", config.busyTimeoutMs).toString());
+    const QString busyRetries = envOr("LMS_BUSY_RETRIES", settings.value("busy_retries", config.busyRetries).toString());
+    config.databaseName = envOr("LMS_DB_PATH", settings.value("path", config.databaseName).toString());
+    settings.endGroup();
+
+    settings.beginGroup("metrics");
+    const QString slowQueryMs = envOr("LMS_SLOW_QUERY_MS", settings.value("slow_query_ms", config.slowQueryMs).toString());
+    const QString statsDumpSec = envOr("LMS_STATS_DUMP_SEC", settings.value("stats_dump_sec", config.statsDumpIntervalSec).toString());
+    config.slowQueryLog = envOr("LMS_SLOW_QUERY_LOG", settings.value("slow_query_log", config.slowQueryLog).toString());
+    settings.endGroup();
+
+    config.journalMode = validated(journalMode, {"DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF"},
+                                   config.journalMode, "journal_mode");
+    config.synchronous = validated(synchronous, {"OFF", "NORMAL", "FULL", "EXTRA"},
+                                   config.synchronous, "synchronous");
+    config.tempStore = validated(tempStore, {"DEFAULT", "FILE", "MEMORY"}, config.tempStore, "temp_store");
+
+    bool ok = false;
+    if (const int value = cacheSize.toInt(&ok); ok) {
+        config.cacheSize = value;
+    } else {
+        qDebug() << "Ignoring invalid cache_size value" << cacheSize;
+    }
+    if (const qint64 value = mmapSize.toLongLong(&ok); ok && value >= 0) {
+        config.mmapSize = value;
+    } else {
+        qDebug() << "Ignoring invalid mmap_size value" << mmapSize;
+    }
+    if (const int value = busyTimeout.toInt(&ok); ok && value >= 0) {
+        config.busyTimeoutMs = value;
+    } else {
+        qDebug() << "Ignoring invalid busy_timeout value" << busyTimeout;
+    }
+    if (const int value = busyRetries.toInt(&ok); ok && value >= 0) {
+        config.busyRetries = value;
+    } else {
+        qDebug() << "Ignoring invalid busy_retries value" << busyRetries;
+    }
+    if (const int value = slowQueryMs.toInt(&ok); ok && value >= 0) {
+        config.slowQueryMs = value;
+    } else {
+        qDebug() << "Ignoring invalid slow_query_ms value" << slowQueryMs;
+    }
+    if (const int value = statsDumpSec.toInt(&ok); ok && value >= 0) {
+        config.statsDumpIntervalSec = value;
+    } else {
+        qDebug() << "Ignoring invalid stats_dump_sec value" << statsDumpSec;
+    }
+    return config;
+}
+
+bool DbConfig::apply(const QSqlDatabase& db) const
+{
+    const QStringList pragmas = {
+        QString("PRAGMA journal_mode = %1").arg(journalMode),
+        QString("PRAGMA synchronous = %1").arg(synchronous),
+        QString("PRAGMA cache_size = %1").arg(cacheSize),
+        QString("PRAGMA mmap_size = %1").arg(mmapSize),
+        QString("PRAGMA temp_store = %1").arg(tempStore),
+        QString("PRAGMA busy_timeout = %1").arg(busyTimeoutMs),
+    };
+    bool ok = true;
+    QSqlQuery query(db);
+    for (const QString& pragma : pragmas) {
+        if (!query.exec(pragma)) {
+            qDebug() << "Failed to apply" << pragma << ":" << query.lastError().text();
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+void DbConfig::logEffective(const QSqlDatabase& db) const
+{
+    qDebug().nospace() << "SQLite settings for " << db.databaseName()
+        << ": journal_mode=" << pragmaValue(db, "journal_mode").toString()
+        << " synchronous=" << pragmaValue(db, "synchronous").toInt()
+        << " cache_size=" << pragmaValue(db, "cache_size").toInt()
+        << " mmap_size=" << pragmaValue(db, "mmap_size").toLongLong()
+        << " temp_store=" << pragmaValue(db, "temp_store").toInt()
+        << " busy_timeout=" << pragmaValue(db, "busy_timeout").toInt();
+}
+
+void DbConfig::applyMetrics() const
+{
+    QueryMetrics& metrics = QueryMetrics::instance();
+    metrics.setSlowQueryThresholdMs(slowQueryMs);
+    metrics.setSlowQueryLogPath(slowQueryLog);
+}
@@ -1,24 +1,102 @@
 #include "dbManager.h"
+#include "queryMetrics.h"
+#include <QElapsedTimer>
 #include <QSqlError>
 #include <QUuid>
+#include <mutex>
 
-DbManager::DbManager(QSqlDatabase& db)
-    : m_db(db)
+DbManager::DbManager(const DbConfig& config)
+    : m_config(config)
+    , m_ownerThread(QThread::currentThread())
 {
+    static std::atomic<int> pools = 0;
+    m_poolName = QString("lms_pool%1").arg(pools++);
 }
 
 DbManager::~DbManager()
 {
+    QMutexLocker locker(&m_poolMutex);
+    for (DbConnection* connection : std::as_const(m_connections)) {
+        closeConnection(connection);
+    }
+    m_connections.clear();
+}
+
+DbConnection& DbManager::connection() const
+{
+    QThread* thread = QThread::currentThread();
+    QMutexLocker locker(&m_poolMutex);
+    if (DbConnection* existing = m_connections.value(thread)) {
+        return *existing;
+    }
+
+    auto* connection = new DbConnection;
+    connection->name = QString("%1_%2").arg(m_poolName).arg(reinterpret_cast<quintptr>(thread), 0, 16);
+    connection->db = QSqlDatabase::addDatabase("QSQLITE", connection->name);
+    connection->db.setDatabaseName(m_config.databaseName);
+    if (connection->db.open()) {
+        m_config.apply(connection->db);
+    } else {
+        qDebug() << "Error: connection" << connection->name << "failed:" << connection->db.lastError().text();
+    }
+    if (thread != m_ownerThread) {
+        // Direct, so it runs on the finishing thread itself, the only one allowed to close it
+        connection->threadFinished = QObject::connect(thread, &QThread::finished, thread, [this]() {
+            releaseConnection();
+        }, Qt::DirectConnection);
+    }
+    m_connections.insert(thread, connection);
+    return *connection;
+}
+
+bool DbManager::open() const
+{
+    DbConnection& current = connection();
+    if (!current.db.isOpen() && current.db.open()) {
+        m_config.apply(current.db);
+    }
+    return current.db.isOpen();
+}
+
+void DbManager::releaseConnection() const
+{
+    QMutexLocker locker(&m_poolMutex);
+    if (DbConnection* connection = m_connections.take(QThread::currentThread())) {
+        closeConnection(connection);
+    }
+}
+
+qsizetype DbManager::connectionCount() const
+{
+    QMutexLocker locker(&m_poolMutex);
+    return m_connections.size();
+}
+
+void DbManager::closeConnection(DbConnection* connection)
+{
+    QObject::disconnect(connection->threadFinished);
+    // Cached statements must be released before the connection is closed
+    connection->statements.clear();
+    connection->db.close();
+    connection->db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(connection->name);
+    delete connection;
+}
+
+bool DbManager::isWrite(const QString& sql)
+{
+    return !sql.trimmed().startsWith(QLatin1String("SELECT"), Qt::CaseInsensitive);
 }
 
 bool DbManager::createTables() const
 {
-    if (!m_db.isOpen()) {
+    if (!open()) {
         qDebug() << "Database is not open.";
         return false;
     }
 
-    QSqlQuery query(m_db);
+    const std::lock_guard writeLock(m_writeMutex);
+    QSqlQuery query(database());
 
     // Create tables based on their schemas
     if (!query.exec(tableSchemaToSql(DbTable::Books))) {
@@ -45,6 +123,59 @@ bool DbManager::createTables() const
     }
     qDebug() << "Borrow records table created or already exists.";
 
+    for (const DbTable table : {DbTable::Books, DbTable::Clients, DbTable::Families, DbTable::BorrowRecords}) {
+        for (const QString& sql : tableIndexesToSql(table)) {
+            if (!query.exec(sql)) {
+                qDebug() << "Failed to create index on" << getTableName(table) << ":" << query.lastError().text();
+                return false;
+            }
+        }
+    }
+    qDebug() << "Indexes created or already exist.";
+
+    if (createFullTextIndex()) {
+        qDebug() << "Full-text index created or already exists.";
+    } else {
+        qDebug() << "Full-text search unavailable; book search falls back to scanning the catalog.";
+    }
+
+    return true;
+}
+
+bool DbManager::createFullTextIndex() const
+{
+    QSqlQuery query(database());
+    // An index added to an existing database has to be filled from books once
+    const bool existed = query.exec("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'books_fts'")
+        && query.next();
+    query.finish();
+
+    // External-content table: the text stays in books, the index holds only
+    // tokens. Two- and three-character prefix indexes keep "as you type"
+    // queries from scanning the whole vocabulary.
+    const QStringList statements = {
+        "CREATE VIRTUAL TABLE IF NOT EXISTS books_fts USING fts5(title, author, content='books', "
+        "content_rowid='id', tokenize='unicode61 remove_diacritics 2', prefix='2 3')",
+        "CREATE TRIGGER IF NOT EXISTS books_fts_insert AFTER INSERT ON books BEGIN "
+        "INSERT INTO books_fts(rowid, title, author) VALUES (new.id, new.title, new.author); END",
+        "CREATE TRIGGER IF NOT EXISTS books_fts_delete AFTER DELETE ON books BEGIN "
+        "INSERT INTO books_fts(books_fts, rowid, title, author) VALUES ('delete', old.id, old.title, old.author); END",
+        // Copy and borrow count updates do not touch the index
+        "CREATE TRIGGER IF NOT EXISTS books_fts_update AFTER UPDATE OF title, author ON books BEGIN "
+        "INSERT INTO books_fts(books_fts, rowid, title, author) VALUES ('delete', old.id, old.title, old.author); "
+        "INSERT INTO books_fts(rowid, title, author) VALUES (new.id, new.title, new.author); END",
+    };
+    for (const QString& sql : statements) {
+        if (!query.exec(sql)) {
+            qDebug() << "Failed to create full-text index:" << query.lastError().text();
+            return false;
+        }
+    }
+    if (!existed && !query.exec("INSERT INTO books_fts(books_fts) VALUES ('rebuild')")) {
+        qDebug() << "Failed to build full-text index:" << query.lastError().text();
+        return false;
+    }
+    m_fullTextSearch = true;
     return true;
 }
 
@@ -94,6 +225,28 @@ auto DbManager::getSchemaForTable(const DbTable table) -> QVariantMap
     return schema;
 }
 
+auto DbManager::getIndexesForTable(const DbTable table) -> QList<IndexSchema>
+{
+    // Each index follows a lookup that Library performs
+    switch (table) {
+    case DbTable::Books:
+        // Title and author lookups made against the database; Library answers
+        // findBookByTitleAndAuthor from the catalog index
+        return {{"idx_books_title_author", {"title", "author"}}};
+    case DbTable::Clients:
+        // getClientsByFamilyName
+        return {{"idx_clients_family", {"family"}}};
+    case DbTable::BorrowRecords:
+        // getBorrowRecordsByClientId and the already-borrowed check in borrowBook
+        // share the client_id prefix; getBorrowRecordsByBookId uses the second one.
+        // The last one ends in the implicit rowid, so a client's records page in id order.
+        return {{"idx_borrow_records_client_book", {"client_id", "book_id", "is_returned"}},
+                {"idx_borrow_records_book", {"book_id", "is_returned"}},
+                {"idx_borrow_records_client", {"client_id"}}};
+    default:
+        return {};
+    }
+}
 
 QString DbManager::tableSchemaToSql(DbTable table)
 {
@@ -115,6 +268,17 @@ QString DbManager::tableSchemaToSql(DbTable table)
     return QString("CREATE TABLE IF NOT EXISTS %1 (%2%3);")
         .arg(getTableName(table), columns.join(", "), foreignKeys);
 }
+
+QStringList DbManager::tableIndexesToSql(const DbTable table)
+{
+    QStringList statements;
+    for (const IndexSchema& index : getIndexesForTable(table)) {
+        statements << QString("CREATE INDEX IF NOT EXISTS %1 ON %2 (%3);")
+            .arg(index.name, getTableName(table), index.columns.join(", "));
+    }
+    return statements;
+}
+
 QUuid DbManager::generateUUID(const QString& args) const
 {
     return QUuid::createUuidV3(QUuid::fromString(args), _key);
@@ -141,94 +305,487 @@ QString DbManager::getTableName(DbTable table)
     }
     return "";
 }
-std::pair<bool, QSqlQuery> DbManager::executeAction(DbAction action, DbTable table, const QVariantMap& args) const
+QString DbManager::statementKey(const DbAction action, const DbTable table, const QVariantMap& args)
 {
-    QSqlQuery query(m_db);
-    QString tableName = getTableName(table);
+    // QVariantMap keeps its keys sorted, so the same column set always yields the same key
+    QString key = QString::number(static_cast<int>(action));
+    key += QLatin1Char('|');
+    key += QString::number(static_cast<int>(table));
+    for (auto it = args.constBegin(); it != args.constEnd(); ++it) {
+        key += QLatin1Char('|');
+        key += it.key();
+    }
+    return key;
+}
+
+PreparedStatement* DbManager::preparedStatement(const DbAction action, const DbTable table, const QVariantMap& args) const
+{
+    const QString key = statementKey(action, table, args);
+    if (PreparedStatement* cached = findStatement(key)) {
+        return cached;
+    }
+
+    const QString tableName = getTableName(table);
+    QStringList columns;
     QString sql;
 
     switch (action) {
     case DbAction::Insert: {
-        // Get the schema for the table to ensure we use the correct keys and order
-        QVariantMap schema = getSchemaForTable(table);
-
-        QStringList fields;
-        QStringList values;
-        QVariantMap argsMap;
-
-        // Iterate through the schema to build the SQL query
-        for (auto it = schema.begin(); it != schema.end(); ++it) {
-            // Handle ID generation if it's not provided in the arguments
-            if (args.contains(it.key())) {
-                argsMap[it.key()] = args[it.key()];
+        // Get the schema for the table to ensure we only insert known columns
+        const QVariantMap schema = getSchemaForTable(table);
+        for (auto it = args.constBegin(); it != args.constEnd(); ++it) {
+            if (schema.contains(it.key())) {
+                columns << it.key();
             }
-            else
-            {
-                qDebug()<<"Try to insert without required field "<<it.key();
-            }
-        }
-        for (auto it = argsMap.begin(); it != argsMap.end(); ++it) {
-            fields << it.key();
-            values << ":" + it.key();
         }
-
-        sql = QString("INSERT INTO %1 (%2) VALUES (%3)").arg(tableName).arg(fields.join(", ")).arg(values.join(", "));
-        query.prepare(sql);
-
-        // Bind values from the args map
-        for (auto it = argsMap.begin(); it != argsMap.end(); ++it) {
-            query.bindValue(":" + it.key(), it.value());
+        for (auto it = schema.constBegin(); it != schema.constEnd(); ++it) {
+            if (!args.contains(it.key())) {
+                qDebug() << "Try to insert without required field " << it.key();
+            }
         }
+        QStringList placeholders;
+        placeholders.fill("?", columns.size());
+        sql = QString("INSERT INTO %1 (%2) VALUES (%3)").arg(tableName, columns.join(", "), placeholders.join(", "));
         break;
     }
 
     case DbAction::Select: {
         QStringList conditions;
         sql = QString("SELECT * FROM %1").arg(tableName);
-        for (auto it = args.begin(); it != args.end(); ++it) {
-            conditions << QString("%1 = :%1").arg(it.key());
+        for (auto it = args.constBegin(); it != args.constEnd(); ++it) {
+            conditions << QString("%1 = ?").arg(it.key());
+            columns << it.key();
         }
         if (!conditions.isEmpty()) {
             sql += " WHERE " + conditions.join(" AND ");
-            query.prepare(sql);
-            for (auto it = args.begin(); it != args.end(); ++it) {
-                query.bindValue(":" + it.key(), it.value());
-            }
-        } else {
-            query.prepare(sql);
         }
         break;
     }
 
     case DbAction::Update: {
         QStringList fields;
-        sql = QString("UPDATE %1 SET ").arg(tableName);
-        for (auto it = args.begin(); it != args.end(); ++it) {
+        for (auto it = args.constBegin(); it != args.constEnd(); ++it) {
             if (it.key() != "id") {
-                fields << QString("%1 = :%1").arg(it.key());
+                fields << QString("%1 = ?").arg(it.key());
+                columns << it.key();
             }
         }
-        sql += fields.join(", ") + " WHERE id = :id";
-        query.prepare(sql);
-        for (auto it = args.begin(); it != args.end(); ++it) {
-            query.bindValue(":" + it.key(), it.value());
-        }
+        columns << "id";
+        sql = QString("UPDATE %1 SET %2 WHERE id = ?").arg(tableName, fields.join(", "));
         break;
     }
 
     case DbAction::Delete: {
-        sql = QString("DELETE FROM %1 WHERE id = :id").arg(tableName);
-        query.prepare(sql);
-        query.bindValue(":id", args.value("id"));
+        columns << "id";
+        sql = QString("DELETE FROM %1 WHERE id = ?").arg(tableName);
         break;
     }
     }
-    bool retVal = query.exec();
+
+    // Callers only ever step forward through results; a forward-only query
+    // lets the SQLite driver skip caching every row it has already returned
+    const QString label = DbActionToString(action) + ' ' + tableName;
+    return storeStatement(key, sql, columns, label, action == DbAction::Select);
+}
+
+PreparedStatement* DbManager::findStatement(const QString& key) const
+{
+    DbConnection& current = connection();
+    if (const auto it = current.statements.find(key); it != current.statements.end()) {
+        ++m_cacheHits;
+        return &it.value();
+    }
+    return nullptr;
+}
+
+PreparedStatement* DbManager::storeStatement(const QString& key, const QString& sql, const QStringList& columns,
+                                             const QString& label, const bool forwardOnly) const
+{
+    ++m_cacheMisses;
+    DbConnection& current = connection();
+    QSqlQuery query(current.db);
+    query.setForwardOnly(forwardOnly);
+    if (!query.prepare(sql)) {
+        qDebug() << "Error preparing" << sql << ":" << query.lastError().text();
+        return nullptr;
+    }
+    return &current.statements.insert(key, PreparedStatement{std::move(query), columns, label, sql}).value();
+}
+
+QSqlQuery& DbManager::reusableQuery(PreparedStatement& statement) const
+{
+    QSqlQuery& query = statement.query;
+    // A SELECT that was neither read to the end nor finished may be a live
+    // cursor in the caller's hands; its copy keeps the old result set
+    if (query.isActive() && query.isSelect() && query.at() != QSql::AfterLastRow) {
+        // Each of these is a caller that forgot finish(); name it so it can be fixed
+        qDebug() << "Re-preparing" << statement.label << "because its last cursor was not finished";
+        ++m_cacheMisses;
+        QSqlQuery fresh(connection().db);
+        fresh.setForwardOnly(query.isForwardOnly());
+        if (fresh.prepare(statement.sql)) {
+            query = std::move(fresh);
+            return query;
+        }
+        qDebug() << "Error preparing" << statement.sql << ":" << fresh.lastError().text();
+    }
+    query.finish();
+    return query;
+}
+
+PreparedStatement* DbManager::insertRowsStatement(const DbTable table, const QStringList& columns, const int rowCount) const
+{
+    const QString key = QString("bulk|%1|%2|%3").arg(static_cast<int>(table)).arg(columns.join(',')).arg(rowCount);
+    if (PreparedStatement* cached = findStatement(key)) {
+        return cached;
+    }
+    QStringList placeholders;
+    placeholders.fill("?", columns.size());
+    const QString tuple = "(" + placeholders.join(", ") + ")";
+    QStringList tuples;
+    tuples.fill(tuple, rowCount);
+    const QString sql = QString("INSERT INTO %1 (%2) VALUES %3")
+        .arg(getTableName(table), columns.join(", "), tuples.join(", "));
+    return storeStatement(key, sql, columns, "BULK INSERT " + getTableName(table));
+}
+
+QString DbManager::keyColumn(const DbTable table)
+{
+    return table == DbTable::Families ? QString("name") : QString("id");
+}
+
+PreparedStatement* DbManager::pageStatement(const DbTable table, const QVariantMap& where, const QString& orderColumn, const bool first) const
+{
+    QString key = QString("page|%1|%2|%3").arg(static_cast<int>(table)).arg(orderColumn).arg(first);
+    for (auto it = where.constBegin(); it != where.constEnd(); ++it) {
+        key += QLatin1Char('|');
+        key += it.key();
+    }
+    if (PreparedStatement* cached = findStatement(key)) {
+        return cached;
+    }
+
+    const QString tableName = getTableName(table);
+    const QString keyName = keyColumn(table);
+    QStringList conditions;
+    QStringList columns;
+    for (auto it = where.constBegin(); it != where.constEnd(); ++it) {
+        conditions << QString("%1 = ?").arg(it.key());
+        columns << it.key();
+    }
+    // The key breaks ties, so every row has exactly one position in the order
+    const bool byKey = orderColumn == keyName;
+    const QString order = byKey ? keyName : QString("%1, %2").arg(orderColumn, keyName);
+    if (!first) {
+        conditions << (byKey ? QString("%1 > ?").arg(keyName) : QString("(%1) > (?, ?)").arg(order));
+    }
+    QString sql = QString("SELECT * FROM %1").arg(tableName);
+    if (!conditions.isEmpty()) {
+        sql += " WHERE " + conditions.join(" AND ");
+    }
+    sql += QString(" ORDER BY %1 LIMIT ?").arg(order);
+    return storeStatement(key, sql, columns, "PAGE " + tableName, true);
+}
+
+std::pair<bool, QSqlQuery> DbManager::selectPage(const DbTable table, const QVariantMap& where, const QString& orderColumn,
+                                                 const PageCursor& after, const int limit) const
+{
+    // Column names are spliced into the SQL, so only schema columns are accepted
+    const QVariantMap schema = getSchemaForTable(table);
+    for (auto it = where.constBegin(); it != where.constEnd(); ++it) {
+        if (!schema.contains(it.key())) {
+            qDebug() << "Unknown column" << it.key() << "for table" << getTableName(table);
+            return {false, QSqlQuery(database())};
+        }
+    }
+    if (!schema.contains(orderColumn)) {
+        qDebug() << "Unknown order column" << orderColumn << "for table" << getTableName(table);
+        return {false, QSqlQuery(database())};
+    }
+
+    PreparedStatement* statement = pageStatement(table, where, orderColumn, after.atStart());
+    if (!statement) {
+        return {false, QSqlQuery(database())};
+    }
+    QSqlQuery& query = reusableQuery(*statement);
+    int position = 0;
+    for (const QString& column : std::as_const(statement->columns)) {
+        query.bindValue(position++, where.value(column));
+    }
+    if (!after.atStart()) {
+        if (orderColumn != keyColumn(table)) {
+            query.bindValue(position++, after.value);
+        }
+        query.bindValue(position++, after.key);
+    }
+    query.bindValue(position, qMax(0, limit));
+
+    const bool retVal = execTimed(query, statement->label);
+    if (!retVal) {
+        qDebug() << "Error reading page of" << getTableName(table) << ":" << query.lastError().text();
+    }
+    return {retVal, query};
+}
+
+PageCursor DbManager::cursorAfter(const DbTable table, const QString& orderColumn, const QSqlQuery& row)
+{
+    return {row.value(orderColumn), row.value(keyColumn(table))};
+}
+
+std::pair<bool, QSqlQuery> DbManager::executeSql(const QString& sql, const QVariantList& values) const
+{
+    PreparedStatement* statement = findStatement(sql);
+    if (!statement) {
+        // Raw statements are grouped by their text, long ones cut short for the dump
+        statement = storeStatement(sql, sql, {}, sql.simplified().left(80), true);
+    }
+    if (!statement) {
+        return {false, QSqlQuery(database())};
+    }
+
+    QSqlQuery& query = reusableQuery(*statement);
+    for (int i = 0; i < values.size(); ++i) {
+        query.bindValue(i, values.at(i));
+    }
+    // Inside a transaction this thread already holds the write lock
+    std::unique_lock writeLock(m_writeMutex, std::defer_lock);
+    if (isWrite(sql) && !inTransaction()) {
+        writeLock.lock();
+    }
+    bool retVal = execTimed(query, statement->label);
     if (!retVal) {
-        qDebug() << "Error executing action" << DbActionToString(action) << "on table" << tableName << ":" << query.lastError().text();
+        qDebug() << "Error executing" << sql << ":" << query.lastError().text();
+    }
+    return {retVal, query};
+}
+
+bool DbManager::forEachRow(const DbTable table, const QVariantMap& where, const std::function<bool(const QSqlQuery&)>& visitor) const
+{
+    auto [success, query] = executeAction(DbAction::Select, table, where);
+    if (!success) {
+        return false;
+    }
+    while (query.next()) {
+        if (!visitor(query)) {
+            break;
+        }
+    }
+    const bool failed = query.lastError().isValid();
+    if (failed) {
+        qDebug() << "Error reading rows from" << getTableName(table) << ":" << query.lastError().text();
+    }
+    query.finish();
+    return !failed;
+}
+
+bool DbManager::insertRows(const DbTable table, const QStringList& columns, const QList<QVariantList>& rows) const
+{
+    const QVariantMap schema = getSchemaForTable(table);
+    for (const QString& column : columns) {
+        if (!schema.contains(column)) {
+            qDebug() << "Unknown column" << column << "for table" << getTableName(table);
+            return false;
+        }
+    }
+    if (columns.isEmpty() || rows.isEmpty()) {
+        return !columns.isEmpty();
+    }
+
+    // Full batches share one multi-row statement; the tail goes row by row
+    // so the cache does not fill up with one statement per leftover size.
+    const int rowsPerStatement = qMax(1, MaxBoundParameters / static_cast<int>(columns.size()));
+    std::unique_lock writeLock(m_writeMutex, std::defer_lock);
+    if (!inTransaction()) {
+        writeLock.lock();
+    }
+    qsizetype next = 0;
+    while (next < rows.size()) {
+        const int batch = rows.size() - next >= rowsPerStatement ? rowsPerStatement : 1;
+        PreparedStatement* statement = insertRowsStatement(table, columns, batch);
+        if (!statement) {
+            return false;
+        }
+        QSqlQuery& query = statement->query;
+        int position = 0;
+        for (int i = 0; i < batch; ++i) {
+            const QVariantList& row = rows.at(next + i);
+            for (int c = 0; c < columns.size(); ++c) {
+                query.bindValue(position++, row.value(c));
+            }
+        }
+        if (!execTimed(query, statement->label)) {
+            qDebug() << "Error bulk inserting into" << getTableName(table) << ":" << query.lastError().text();
+            return false;
+        }
+        next += batch;
+    }
+    return true;
+}
+
+void DbManager::clearStatementCache() const
+{
+    connection().statements.clear();
+}
+
+std::pair<bool, QSqlQuery> DbManager::executeAction(DbAction action, DbTable table, const QVariantMap& args) const
+{
+    PreparedStatement* statement = preparedStatement(action, table, args);
+    if (!statement) {
+        return {false, QSqlQuery(database())};
+    }
+
+    // Release the previous result set before rebinding the cached statement
+    QSqlQuery& query = reusableQuery(*statement);
+    for (int i = 0; i < statement->columns.size(); ++i) {
+        query.bindValue(i, args.value(statement->columns.at(i)));
+    }
+
+    std::unique_lock writeLock(m_writeMutex, std::defer_lock);
+    if (action != DbAction::Select && !inTransaction()) {
+        writeLock.lock();
+    }
+    bool retVal = execTimed(query, statement->label);
+    if (!retVal) {
+        qDebug() << "Error executing action" << DbActionToString(action) << "on table" << getTableName(table) << ":" << query.lastError().text();
     }
 
     return {retVal, query} ;
 }
 
+bool DbManager::execRaw(const QString& sql) const
+{
+    QSqlQuery query(database());
+    if (!execTimed(query, sql, sql)) {
+        qDebug() << "Error executing" << sql << ":" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool DbManager::execTimed(QSqlQuery& query, const QString& label, const QString& sql) const
+{
+    // busy_timeout has already waited inside SQLite by the time a statement
+    // fails as busy. Outside a transaction it is safe to try again; inside one
+    // only the caller can decide to retry the whole transaction.
+    const int attempts = inTransaction() ? 1 : 1 + m_config.busyRetries;
+    bool ok = false;
+    for (int attempt = 0; attempt < attempts; ++attempt) {
+        if (attempt > 0) {
+            qDebug() << "Database busy, retrying" << label << "attempt" << attempt;
+            QThread::msleep(10u << attempt);
+        }
+        QElapsedTimer timer;
+        timer.start();
+        ok = sql.isEmpty() ? query.exec() : query.exec(sql);
+        const qint64 elapsedNs = timer.nsecsElapsed();
+        QueryMetrics& metrics = QueryMetrics::instance();
+        metrics.record(label, elapsedNs);
+        if (metrics.isSlow(elapsedNs)) {
+            metrics.recordSlow(label, elapsedNs, query.lastQuery(), query.boundValues());
+        }
+        if (ok || !isBusy(query.lastError())) {
+            break;
+        }
+    }
+    return ok;
+}
+
+bool DbManager::isBusy(const QSqlError& error)
+{
+    // Extended result codes keep the primary code in the low byte
+    bool ok = false;
+    const int code = error.nativeErrorCode().toInt(&ok) & 0xff;
+    return ok && (code == 5 || code == 6); // SQLITE_BUSY, SQLITE_LOCKED
+}
+
+bool DbManager::beginTransaction() const
+{
+    DbConnection& current = connection();
+    if (current.transactionDepth == 0) {
+        // The write lock spans the whole transaction and is released by its end
+        m_writeMutex.lock();
+    }
+    // IMMEDIATE takes SQLite's write lock up front, so a transaction that
+    // reads before it writes cannot fail half way when another process writes
+    const QString sql = current.transactionDepth == 0
+        ? QString("BEGIN IMMEDIATE")
+        : QString("SAVEPOINT sp_%1").arg(current.transactionDepth);
+    if (!execRaw(sql)) {
+        if (current.transactionDepth == 0) {
+            m_writeMutex.unlock();
+        }
+        return false;
+    }
+    ++current.transactionDepth;
+    return true;
+}
+
+bool DbManager::commitTransaction() const
+{
+    DbConnection& current = connection();
+    if (current.transactionDepth == 0) {
+        qDebug() << "Commit requested without an active transaction.";
+        return false;
+    }
+    const QString sql = current.transactionDepth == 1
+        ? QString("COMMIT")
+        : QString("RELEASE SAVEPOINT sp_%1").arg(current.transactionDepth - 1);
+    if (!execRaw(sql)) {
+        return false;
+    }
+    if (--current.transactionDepth == 0) {
+        m_writeMutex.unlock();
+    }
+    return true;
+}
+
+bool DbManager::rollbackTransaction() const
+{
+    DbConnection& current = connection();
+    if (current.transactionDepth == 0) {
+        qDebug() << "Rollback requested without an active transaction.";
+        return false;
+    }
+    --current.transactionDepth;
+    if (current.transactionDepth == 0) {
+        const bool ok = execRaw("ROLLBACK");
+        m_writeMutex.unlock();
+        return ok;
+    }
+    // ROLLBACK TO keeps the savepoint open, so release it as well
+    const QString savepoint = QString("sp_%1").arg(current.transactionDepth);
+    return execRaw("ROLLBACK TO SAVEPOINT " + savepoint) && execRaw("RELEASE SAVEPOINT " + savepoint);
+}
 
+DbTransaction::DbTransaction(const DbManager& dbManager)
+    : m_dbManager(dbManager)
+    , m_active(dbManager.beginTransaction())
+{
+}
+
+DbTransaction::~DbTransaction()
+{
+    rollback();
+}
+
+bool DbTransaction::commit()
+{
+    if (!m_active) {
+        return false;
+    }
+    m_active = false;
+    if (!m_dbManager.commitTransaction()) {
+        // A failed COMMIT leaves the transaction open, undo it
+        m_dbManager.rollbackTransaction();
+        return false;
+    }
+    return true;
+}
+
+void DbTransaction::rollback()
+{
+    if (m_active) {
+        m_active = false;
+        m_dbManager.rollbackTransaction();
+    }
+}
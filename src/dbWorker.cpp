@@ -0,0 +1,17 @@
+#include "dbWorker.h"
+
+DbWorker::DbWorker(const DbManager& dbManager, const int maxThreads)
+    : m_dbManager(dbManager)
+{
+    m_pool.setObjectName("DbWorker");
+    m_pool.setMaxThreadCount(qMax(1, maxThreads));
+    // An expiring thread would take its connection with it
+    m_pool.setExpiryTimeout(-1);
+}
+
+DbWorker::~DbWorker()
+{
+    // Pool threads release their connections as they finish, which happens
+    // when m_pool is destroyed, before the DbManager goes away
+    m_pool.waitForDone();
+}
@@ -23,9 +23,9 @@ EditClientDialog::~EditClientDialog()
     delete ui;
 }
 
-void EditClientDialog::handleEvent(const EventType event)
+void EditClientDialog::handleEvent(const ChangeBatch& changes)
 {
-    Q_UNUSED(event);
+    Q_UNUSED(changes);
 }
 
 QString EditClientDialog::getName() const {
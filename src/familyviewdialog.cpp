@@ -13,18 +13,47 @@ FamilyViewDialog::FamilyViewDialog(QWidget *parent) :
     ui->setupUi(this);
 }
 
-void FamilyViewDialog::handleEvent(const EventType event)
+void FamilyViewDialog::handleEvent(const ChangeBatch& changes)
 {
-    if (event == EventType::ClientsUpdated || event == EventType::FamiliesUpdated) {
-        // Refresh the family info if needed
-        // This requires storing the current family name and clients
-        // For simplicity, we will just clear the list here
-        ui->clientsListWidget->clear();
-        m_clients.clear();
-        const QString familyName = ui->familyNameLabel->text().remove("Family: ").trimmed();
-        const QList<Client> clients = Library::instance()->getClientsByFamilyName(familyName);
-        setFamilyInfo(familyName,clients);
+    for (const ChangeEvent& change : changes) {
+        switch (change.kind) {
+        case ChangeEvent::Kind::CatalogReloaded:
+            setFamilyInfo(m_familyName, Library::instance()->getClientsByFamilyName(m_familyName));
+            break;
+        case ChangeEvent::Kind::ClientAdded:
+        case ChangeEvent::Kind::ClientEdited:
+        case ChangeEvent::Kind::ClientRemoved:
+            updateClient(change.clientId);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void FamilyViewDialog::updateClient(const int clientId)
+{
+    qsizetype row = -1;
+    for (qsizetype i = 0; i < m_clients.size(); ++i) {
+        if (m_clients.at(i).id() == clientId) {
+            row = i;
+            break;
+        }
+    }
+    // A client can also join or leave the family through an edit
+    const Client client = Library::instance()->getClientById(clientId);
+    const bool member = client.id() >= 0 && client.family() == m_familyName;
+    if (row >= 0 && !member) {
+        m_clients.removeAt(row);
+        delete ui->clientsListWidget->takeItem(static_cast<int>(row));
+    } else if (row >= 0) {
+        m_clients[row] = client;
+        ui->clientsListWidget->item(static_cast<int>(row))->setText(client.toString());
+    } else if (member) {
+        m_clients.append(client);
+        ui->clientsListWidget->addItem(client.toString());
     }
+    ui->clientCountLabel->setText("Number of Clients: " + QString::number(m_clients.size()));
 }
 
 FamilyViewDialog::~FamilyViewDialog()
@@ -34,9 +63,11 @@ FamilyViewDialog::~FamilyViewDialog()
 
 void FamilyViewDialog::setFamilyInfo(const QString &familyName, const QList<Client> &clients)
 {
+    m_familyName = familyName;
     ui->familyNameLabel->setText("Family: " + familyName);
     ui->clientCountLabel->setText("Number of Clients: " + QString::number(clients.size()));
     ui->clientsListWidget->clear();
+    m_clients.clear();
     for (const Client& client : clients) {
         ui->clientsListWidget->addItem(client.toString());
         m_clients.append(client);
@@ -0,0 +1,87 @@
+#include "historyExporter.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QSqlRecord>
+#include <QTextStream>
+
+HistoryExporter::HistoryExporter(const DbManager& dbManager)
+    : m_dbManager(dbManager)
+{
+}
+
+HistoryExporter::Format HistoryExporter::formatForPath(const QString& path)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    return suffix == "jsonl" || suffix == "ndjson" ? Format::JsonLines : Format::Csv;
+}
+
+qint64 HistoryExporter::exportBorrowRecords(const QString& path) const
+{
+    return exportBorrowRecords(path, formatForPath(path));
+}
+
+qint64 HistoryExporter::exportBorrowRecords(const QString& path, const Format format) const
+{
+    // QSaveFile only replaces the target once everything has been written
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qDebug() << "Error opening export file" << path << ":" << file.errorString();
+        return -1;
+    }
+    QTextStream out(&file);
+
+    // The header comes from the schema, so an empty history still gets one
+    const QStringList columns = DbManager::getSchemaForTable(DbTable::BorrowRecords).keys();
+    if (format == Format::Csv) {
+        out << columns.join(',') << '\n';
+    }
+    QList<int> positions;
+    qint64 rows = 0;
+    const bool success = m_dbManager.forEachRow(DbTable::BorrowRecords, {}, [&](const QSqlQuery& query) {
+        if (positions.isEmpty()) {
+            // Column positions are resolved once, from the first row
+            const QSqlRecord record = query.record();
+            for (const QString& column : columns) {
+                positions << record.indexOf(column);
+            }
+        }
+        if (format == Format::Csv) {
+            for (int i = 0; i < columns.size(); ++i) {
+                if (i > 0) {
+                    out << ',';
+                }
+                out << csvField(query.value(positions.at(i)).toString());
+            }
+            out << '\n';
+        } else {
+            QJsonObject object;
+            for (int i = 0; i < columns.size(); ++i) {
+                object.insert(columns.at(i), QJsonValue::fromVariant(query.value(positions.at(i))));
+            }
+            out << QJsonDocument(object).toJson(QJsonDocument::Compact) << '\n';
+        }
+        ++rows;
+        return out.status() == QTextStream::Ok;
+    });
+
+    out.flush();
+    if (!success || out.status() != QTextStream::Ok || !file.commit()) {
+        qDebug() << "Error exporting borrow history to" << path;
+        return -1;
+    }
+    qDebug() << "Exported" << rows << "borrow records to" << path;
+    return rows;
+}
+
+QString HistoryExporter::csvField(const QString& value)
+{
+    if (!value.contains(',') && !value.contains('"') && !value.contains('\n') && !value.contains('\r')) {
+        return value;
+    }
+    QString escaped = value;
+    escaped.replace("\"", "\"\"");
+    return "\"" + escaped + "\"";
+}
@@ -4,20 +4,36 @@
 #include <QDebug>
 #include <QVariant>
 #include <QUuid>
+#include <QSet>
+#include <QRegularExpression>
+#include <algorithm>
+#include <optional>
 
-#include "windows/familyviewdialog.h"
-#include "windows/clientDetailDialog.h"
 #include "book.h"
 #include "client.h"
-#include "windowManager.h"
+#include "catalogImporter.h"
+#include "historyExporter.h"
+#include "libraryWriter.h"
+#include "tableDescriptor.h"
 
 Library::Library()
 {
     if (connectToDatabase()) {
-        _dbManager = new DbManager(_db);
         if (!_dbManager->createTables()) {
             qDebug() << "Error: Failed to create database tables.";
         }
+        _worker = new DbWorker(*_dbManager);
+        // Outcomes come back on the writer thread; the catalog and the
+        // signals belong to this one. A waiting sync call may publish them
+        // first, in which case the queued call finds nothing left.
+        _writer = new LibraryWriter(*_dbManager, [this](const QList<CommandOutcome>& outcomes) {
+            QMutexLocker locker(&_committedMutex);
+            const bool wasEmpty = _committed.isEmpty();
+            _committed.append(outcomes);
+            if (wasEmpty) {
+                QMetaObject::invokeMethod(this, &Library::publishCommitted, Qt::QueuedConnection);
+            }
+        });
         qDebug() << "Successfully created database tables.";
         loadBooks();
         qDebug() << "Successfully loaded books from database.";
@@ -26,52 +42,172 @@ Library::Library()
         loadFamilies();
         qDebug() << "Successfully loaded families from database.";
     }
+    if (_config.statsDumpIntervalSec > 0) {
+        connect(&_statsTimer, &QTimer::timeout, this, &Library::dumpQueryStats);
+        _statsTimer.start(_config.statsDumpIntervalSec * 1000);
+    }
 }
 
 Library::~Library()
 {
-    delete _dbManager;
-    if (_db.isOpen()) {
-        _db.close();
+    if (_dbManager) {
+        qDebug() << "Statement cache hits:" << _dbManager->cacheHits() << "misses:" << _dbManager->cacheMisses();
     }
+    dumpQueryStats();
+    // The writer and the worker's pool threads hand their connections back
+    // before the threads go
+    delete _writer;
+    delete _worker;
+    delete _dbManager;
 }
 
 bool Library::connectToDatabase()
 {
-    _db = QSqlDatabase::addDatabase("QSQLITE");
-    _db.setDatabaseName("library.db");
-
-    if (!_db.open()) {
-        qDebug() << "Error: connection with database failed:" << _db.lastError().text();
+    _config = DbConfig::load();
+    _config.applyMetrics();
+    // Connections are per thread; this opens the one for the GUI thread
+    _dbManager = new DbManager(_config);
+    if (!_dbManager->open()) {
+        qDebug() << "Error: connection with database failed.";
+        delete _dbManager;
+        _dbManager = nullptr;
         return false;
     } else {
         qDebug() << "Database connection successful!";
+        // Every pooled connection gets the same settings, so one log covers them all
+        _config.logEffective(_dbManager->database());
         return true;
     }
 }
 
+std::shared_ptr<const Catalog> Library::catalog() const
+{
+    return _catalog.load();
+}
+
+template<typename Edit>
+void Library::editCatalog(Edit&& edit)
+{
+    // Containers are implicitly shared, so the copy is shallow and only the
+    // ones `edit` touches are deep-copied. Writes all happen on this
+    // object's thread, so no two edits race.
+    auto next = std::make_shared<Catalog>(*_catalog.load());
+    edit(*next);
+    _catalog.store(std::move(next));
+}
+
 void Library::loadBooks()
 {
-    _books.clear();
     auto [success, query] = _dbManager->executeAction(DbAction::Select, DbTable::Books,{});
     if (!success)
     {
         qDebug() << "Error loading books from database:" << query.lastError().text();
         return;
     }
-    _books=getBooksListByQuery(query);
+    const QList<Book> books = getBooksListByQuery(query);
+    editCatalog([&books](Catalog& catalog) { catalog.setBooks(books); });
     emit booksUpdated();
 }
 
-const QList<Book>& Library::allBooks() const
+QList<Book> Library::allBooks() const
+{
+    return catalog()->books().toList();
+}
+
+int Library::bookCount() const
+{
+    return static_cast<int>(catalog()->books().size());
+}
+
+std::optional<Book> Library::bookAt(const int row) const
+{
+    const std::shared_ptr<const Catalog> snapshot = catalog();
+    if (row < 0 || row >= snapshot->books().size())
+    {
+        return std::nullopt;
+    }
+    return snapshot->books().at(row);
+}
+
+int Library::bookRow(const int id) const
+{
+    return static_cast<int>(catalog()->bookRow(id));
+}
+
+QStringList Library::searchTerms(const QString& text)
+{
+    static const QRegularExpression separators("[^\\p{L}\\p{N}]+");
+    return text.split(separators, Qt::SkipEmptyParts);
+}
+
+QList<Book> Library::searchBooks(const QString& text, const int limit, const int offset) const
+{
+    const QStringList terms = searchTerms(text);
+    if (terms.isEmpty() || limit <= 0)
+    {
+        return {};
+    }
+    if (!_dbManager->hasFullTextSearch())
+    {
+        return scanBooks(terms, limit, offset);
+    }
+
+    // Quoting keeps words like AND/NOT/NEAR literal; the trailing * makes each a prefix
+    QStringList phrases;
+    for (const QString& term : terms)
+    {
+        phrases << QString("\"%1\"*").arg(term);
+    }
+    auto [success, query] = _dbManager->executeSql(
+        "SELECT rowid FROM books_fts WHERE books_fts MATCH ? ORDER BY bm25(books_fts, 2.0, 1.0) LIMIT ? OFFSET ?",
+        {phrases.join(' '), limit, offset});
+    if (!success)
+    {
+        return {};
+    }
+    // Only ids come back from SQLite; the rows themselves are in the catalog
+    const std::shared_ptr<const Catalog> snapshot = catalog();
+    QList<Book> results;
+    results.reserve(limit);
+    while (query.next())
+    {
+        if (const Book* book = snapshot->book(query.value(0).toInt()))
+        {
+            results.append(*book);
+        }
+    }
+    query.finish();
+    return results;
+}
+
+QList<Book> Library::scanBooks(const QStringList& terms, const int limit, const int offset) const
 {
-    return _books;
+    const std::shared_ptr<const Catalog> snapshot = catalog();
+    QList<Book> results;
+    int skipped = 0;
+    for (const Book& book : snapshot->books())
+    {
+        const bool matches = std::all_of(terms.cbegin(), terms.cend(), [&book](const QString& term) {
+            return book.title().contains(term, Qt::CaseInsensitive) || book.author().contains(term, Qt::CaseInsensitive);
+        });
+        if (!matches || skipped++ < offset)
+        {
+            continue;
+        }
+        results.append(book);
+        if (results.size() == limit)
+        {
+            break;
+        }
+    }
+    return results;
 }
 
 QList<Book> Library::getAvailableBooks() const
 {
+    const std::shared_ptr<const Catalog> snapshot = catalog();
     QList<Book> ret;
-    for (const Book& book : _books)
+    for (const Book& book : snapshot->books())
     {
         if (book.copies() > 0)
             ret.append(book);
@@ -82,29 +218,149 @@ QList<Book> Library::getAvailableBooks() const
 
 void Library::loadClients()
 {
-    _clients.clear();
     auto [success, query]  = _dbManager->executeAction(DbAction::Select, DbTable::Clients,{});
     if (!success)
     {
         qDebug() << "Error loading clients from database:" << query.lastError().text();
         return;
     }
-    _clients=getClientsListByQuery(query);
+    const QList<Client> clients = getClientsListByQuery(query);
+    editCatalog([&clients](Catalog& catalog) { catalog.setClients(clients); });
+}
+
+int Library::reloadAndVerify()
+{
+    auto [booksOk, booksQuery] = _dbManager->executeAction(DbAction::Select, DbTable::Books, {});
+    if (!booksOk)
+    {
+        qDebug() << "Error reloading books from database:" << booksQuery.lastError().text();
+        return -1;
+    }
+    const QList<Book> books = getBooksListByQuery(booksQuery);
+    auto [clientsOk, clientsQuery] = _dbManager->executeAction(DbAction::Select, DbTable::Clients, {});
+    if (!clientsOk)
+    {
+        qDebug() << "Error reloading clients from database:" << clientsQuery.lastError().text();
+        return -1;
+    }
+    const QList<Client> clients = getClientsListByQuery(clientsQuery);
+
+    // Rows only the database has, or whose values differ, are found while
+    // scanning it; rows only the catalog has show up as a count difference.
+    const std::shared_ptr<const Catalog> snapshot = catalog();
+    int mismatches = 0;
+    int matchedBooks = 0;
+    int matchedClients = 0;
+    for (const Book& book : books)
+    {
+        const Book* cached = snapshot->book(book.id());
+        if (!cached || cached->title() != book.title() || cached->author() != book.author()
+            || cached->year() != book.year() || cached->copies() != book.copies()
+            || cached->borrowedCount() != book.borrowedCount())
+        {
+            qDebug() << "Catalog out of sync for book" << book.id();
+            ++mismatches;
+        }
+        if (cached)
+        {
+            ++matchedBooks;
+        }
+    }
+    for (const Client& client : clients)
+    {
+        const Client* cached = snapshot->client(client.id());
+        if (!cached || cached->name() != client.name() || cached->surname() != client.surname()
+            || cached->family() != client.family())
+        {
+            qDebug() << "Catalog out of sync for client" << client.id();
+            ++mismatches;
+        }
+        if (cached)
+        {
+            ++matchedClients;
+        }
+    }
+    mismatches += static_cast<int>(snapshot->books().size()) - matchedBooks;
+    mismatches += static_cast<int>(snapshot->clients().size()) - matchedClients;
+    qDebug() << "Verified catalog against database:" << mismatches << "mismatches.";
+
+    editCatalog([&books, &clients](Catalog& catalog) {
+        catalog.setBooks(books);
+        catalog.setClients(clients);
+    });
+    loadFamilies();
+    emit booksUpdated();
+    emit changed(ChangeEvent::catalogReloaded());
+    return mismatches;
+}
+
+qint64 Library::importBooks(const QString& path)
+{
+    CatalogImporter importer(*_dbManager);
+    connect(&importer, &CatalogImporter::progress, this, &Library::importProgress);
+    const qint64 imported = importer.importFile(path, DbTable::Books);
+    // Rows from completed chunks are committed even if a later chunk failed
+    loadBooks();
+    emit changed(ChangeEvent::catalogReloaded());
+    return imported;
+}
+
+qint64 Library::importClients(const QString& path)
+{
+    CatalogImporter importer(*_dbManager);
+    connect(&importer, &CatalogImporter::progress, this, &Library::importProgress);
+    const qint64 imported = importer.importFile(path, DbTable::Clients);
+    loadClients();
+
+    // Register new families in one transaction and notify once
+    const std::shared_ptr<const Catalog> snapshot = catalog();
+    QStringList added;
+    DbTransaction transaction(*_dbManager);
+    for (const QString& family : snapshot->clientFamilies())
+    {
+        if (family.isEmpty() || snapshot->hasFamily(family))
+        {
+            continue;
+        }
+        QVariantMap args;
+        args["name"] = family;
+        if (_dbManager->executeAction(DbAction::Insert, DbTable::Families, args).first)
+        {
+            added.append(family);
+        }
+    }
+    if (transaction.commit() && !added.isEmpty())
+    {
+        editCatalog([&added](Catalog& catalog) {
+            for (const QString& family : std::as_const(added))
+            {
+                catalog.addFamily(family);
+            }
+        });
+    }
+    emit changed(ChangeEvent::catalogReloaded());
+    return imported;
+}
+
+qint64 Library::exportBorrowHistory(const QString& path) const
+{
+    return HistoryExporter(*_dbManager).exportBorrowRecords(path);
 }
 
 void Library::loadFamilies()
 {
-    _families.clear();
     auto [success, query] =_dbManager->executeAction(DbAction::Select, DbTable::Families,{});
     if (!success)
     {
         qDebug() << "Error loading families from database:" << query.lastError().text();
         return;
     }
+    QStringList families;
+    const RowDecoder<FamilySchema> decoder(query);
     while (query.next()) {
-        _families.append(query.value("name").toString());
+        families.append(decoder.decode(query).name);
     }
-    emit familiesUpdated();
+    editCatalog([&families](Catalog& catalog) { catalog.setFamilies(families); });
 }
 
 void Library::addBook(const QString& title, const QString& author, int year, int copies)
@@ -114,68 +370,54 @@ void Library::addBook(const QString& title, const QString& author, int year, int
     args["author"] = author;
     args["year"] = year;
     args["copies"] = copies;
-    if (auto [success, query] =_dbManager->executeAction(DbAction::Insert, DbTable::Books, args); !success)
+    auto [success, query] =_dbManager->executeAction(DbAction::Insert, DbTable::Books, args);
+    if (!success)
     {
         qDebug() << "Error adding book to database:" << query.lastError().text();
         return;
     }
-    loadBooks();
+    const int id = query.lastInsertId().toInt();
+    editCatalog([&](Catalog& catalog) { catalog.addBook(Book(id, title, author, year, copies)); });
+    emit bookInserted(static_cast<int>(catalog()->books().size()) - 1);
+    emit changed(ChangeEvent::book(ChangeEvent::Kind::BookAdded, id));
 }
 
 void Library::removeBook(int index)
 {
-    if (index < 0 || index >= _books.size()) {
+    const std::shared_ptr<const Catalog> snapshot = catalog();
+    if (index < 0 || index >= snapshot->books().size()) {
         qDebug() << "Invalid book index:" << index;
         return;
     }
+    const int bookId = snapshot->books().at(index).id();
     QVariantMap args;
-    args["id"] = _books[index].id();
+    args["id"] = bookId;
     if (auto [success, query] =_dbManager->executeAction(DbAction::Delete, DbTable::Books, args); !success)
     {
         qDebug() << "Error removing book from database:" << query.lastError().text();
         return;
     }
-    emit booksUpdated();
-    _books.removeAt(index);
-
+    editCatalog([bookId](Catalog& catalog) { catalog.removeBook(bookId); });
+    emit bookRemoved(index);
+    emit changed(ChangeEvent::book(ChangeEvent::Kind::BookRemoved, bookId));
 }
 
 void Library::addCopies(int index, int numCopies)
 {
-    if (index < 0 || index >= _books.size() || numCopies <= 0) {
+    const std::shared_ptr<const Catalog> snapshot = catalog();
+    if (index < 0 || index >= snapshot->books().size() || numCopies <= 0) {
         qDebug() << "Invalid book index or number of copies:" << index << numCopies;
         return;
     }
-    Book& book = _books[index];
-    book.setCopies(book.copies() + numCopies);
-
-    QVariantMap args;
-    args["id"] = book.id();
-    args["copies"] = book.copies();
-    if (auto [success, query] = _dbManager->executeAction(DbAction::Update, DbTable::Books, args); !success)
-    {
-        qDebug() << "Error updating book copies in database:" << query.lastError().text();
-        return;
-    }
-    emit booksUpdated();
+    const int bookId = snapshot->books().at(index).id();
+    submitAndWait(LibraryCommand::addCopies(bookId, numCopies));
 }
 
 void Library::removeCopy(int index)
 {
-    if (index >= 0 && index < _books.size()) {
-        if (Book& book = _books[index]; book.copies() > 0) {
-            book.setCopies(book.copies() - 1);
-            QVariantMap args;
-            args["id"] = book.id();
-            args["copies"] = book.copies();
-            if (auto [success, query] =_dbManager->executeAction(DbAction::Update, DbTable::Books, args); !success)
-            {
-                qDebug() << "Error updating book copies in database:" << query.lastError().text();
-                return;
-            }
-        }
+    if (const std::shared_ptr<const Catalog> snapshot = catalog(); index >= 0 && index < snapshot->books().size()) {
+        submitAndWait(LibraryCommand::removeCopy(snapshot->books().at(index).id()));
     }
-    emit booksUpdated();
 }
 
 void Library::addClient(const Client& client)
@@ -183,31 +425,26 @@ void Library::addClient(const Client& client)
     saveFamily(client.family());
 
     QVariantMap args;
-    args["id"] = client.id();
+    if (client.id() >= 0)
+    {
+        args["id"] = client.id();
+    }
     args["name"] = client.name();
     args["surname"] = client.surname();
     args["family"] = client.family();
-    if (auto [success, query] =_dbManager->executeAction(DbAction::Insert, DbTable::Clients, args); !success)
+    auto [success, query] =_dbManager->executeAction(DbAction::Insert, DbTable::Clients, args);
+    if (!success)
     {
         qDebug() << "Error adding client to database:" << query.lastError().text();
         return;
     }
-    loadClients();
+    const int id = client.id() >= 0 ? client.id() : query.lastInsertId().toInt();
+    editCatalog([&](Catalog& catalog) { catalog.addClient(Client(id, client.name(), client.surname(), client.family())); });
+    emit changed(ChangeEvent::client(ChangeEvent::Kind::ClientAdded, id));
 }
 void Library::addClient(const QString name, const QString surname, const QString family)
 {
-    saveFamily(family);
-
-    QVariantMap args;
-    args["name"] = name;
-    args["surname"] = surname;
-    args["family"] = family;
-    if (auto [success, query] =_dbManager->executeAction(DbAction::Insert, DbTable::Clients, args); !success)
-    {
-        qDebug() << "Error adding client to database:" << query.lastError().text();
-        return;
-    }
-    loadClients();
+    addClient(Client(name, surname, family));
 }
 
 void Library::removeClient(const Client& client)
@@ -219,47 +456,47 @@ void Library::removeClient(const Client& client)
          qDebug() << "Error removing client from database:" << query.lastError().text();
          return;
      }
-    loadClients();
+    editCatalog([&client](Catalog& catalog) { catalog.removeClient(client.id()); });
+    emit changed(ChangeEvent::client(ChangeEvent::Kind::ClientRemoved, client.id()));
 }
 
 Client Library::getClientById(const int id) const
 {
-    QVariantMap args;
-    args["id"] = id;
-    auto [success, query] = _dbManager->executeAction(DbAction::Select, DbTable::Clients, args);
-    if (!success)
-    {
-        qDebug() << "Error retrieving client from database:" << query.lastError().text();
-        return {};
-    }
-    return query.next()? getClientFromQuery(query) : Client{};
+    const std::shared_ptr<const Catalog> snapshot = catalog();
+    const Client* client = snapshot->client(id);
+    return client ? *client : Client{};
 }
 
-const QList<Client>& Library::allClients() const
+QList<Client> Library::allClients() const
 {
-    return _clients;
+    return catalog()->clients().toList();
 }
 
-const QList<QString>& Library::allFamilies() const
+QList<QString> Library::allFamilies() const
 {
-    return _families;
+    return catalog()->families();
 }
 
-QList<Client> Library::getClientsByFamilyName(const QString& familyName) const
+QList<Client> Library::findClients(const QString& query, const int limit) const
 {
-    QVariantMap args;
-    args["family"] = familyName;
-    auto [success, query] = _dbManager->executeAction(DbAction::Select, DbTable::Clients, args);
-    if (!success)
+    const std::shared_ptr<const Catalog> snapshot = catalog();
+    QList<Client> clients;
+    for (const ClientSearchIndex::Match& match : snapshot->findClients(query, limit))
     {
-        qDebug() << "Error retrieving clients by family from database:" << query.lastError().text();
-        return {};
+        if (const Client* client = snapshot->client(match.clientId))
+        {
+            clients.append(*client);
+        }
     }
+    return clients;
+}
 
-    return getClientsListByQuery(query);
+QList<Client> Library::getClientsByFamilyName(const QString& familyName) const
+{
+    return catalog()->clientsInFamily(familyName);
 }
 
-bool Library::updateClient(const int id, const QString& name, const QString& surname, const QString& family) const
+bool Library::updateClient(const int id, const QString& name, const QString& surname, const QString& family)
 {
     saveFamily(family);
 
@@ -269,152 +506,243 @@ bool Library::updateClient(const int id, const QString& name, const QString& sur
     args["surname"] = surname;
     args["family"] = family;
     auto [success, query] = _dbManager->executeAction(DbAction::Update, DbTable::Clients, args);
+    if (success)
+    {
+        editCatalog([&](Catalog& catalog) { catalog.updateClient(Client(id, name, surname, family)); });
+        emit changed(ChangeEvent::client(ChangeEvent::Kind::ClientEdited, id));
+    }
     return success;
 }
 
-void Library::saveFamily(const QString& family) const
+void Library::saveFamily(const QString& family)
 {
+    if (family.isEmpty() || catalog()->hasFamily(family))
+    {
+        return;
+    }
     QVariantMap args;
     args["name"] = family;
-    if (auto [success, query]  =_dbManager->executeAction(DbAction::Select, DbTable::Families, args); !success)
+    if (auto [success, query]  =_dbManager->executeAction(DbAction::Insert, DbTable::Families, args); !success)
     {
-        qDebug() << "Error checking family in database:" << query.lastError().text();
+        qDebug() << "Error saving family in database:" << query.lastError().text();
         return;
     }
+    editCatalog([&family](Catalog& catalog) { catalog.addFamily(family); });
+    emit changed(ChangeEvent::familyAdded(family));
 }
 
 
 
-void Library::on_familyListWidget_doubleClicked(QWidget* p,const Client& client) const
+TransactionResult Library::borrowBook(const int clientId, const BorrowRecord& record)
 {
-    FamilyViewDialog dialog(p);
-    dialog.setFamilyInfo(client.family(), getClientsByFamilyName(client.family()));
-    dialog.exec();
+    return submitAndWait(LibraryCommand::borrowBook(clientId, record)).result;
 }
 
-TransactionResult Library::borrowBook(const int clientId, const BorrowRecord& record)
+TransactionResult Library::returnBook(const int& borrowRecordId)
 {
-    QVariantMap args;
-    const Book *book = getBookById(record.bookId);
-    if (!book)
-    {
-        return TransactionResult::Failure_BookNotFound;
-    }
-    if (book->copies() <= 0)
-    {
-        return TransactionResult::Failure_NoCopies;
+    return submitAndWait(LibraryCommand::returnBook(borrowRecordId)).result;
+}
+
+bool Library::extendBorrowTime(const int& borrowRecordId, const int days)
+{
+    return submitAndWait(LibraryCommand::extendBorrowTime(borrowRecordId, days)).result == TransactionResult::Success;
+}
+
+CommandOutcome Library::submitAndWait(const LibraryCommand& command)
+{
+    CommandOutcome outcome;
+    if (!_writer) {
+        return outcome;
     }
-    // Check if the client has already borrowed this book and not returned it yet
-    QVariantMap checkArgs;
-    checkArgs["client_id"] = clientId;
-    checkArgs["book_id"] = record.bookId;
-    checkArgs["is_returned"] = 0; // Not returned yet
-    auto [successCheck,queryCheck] = _dbManager->executeAction(DbAction::Select, DbTable::BorrowRecords, checkArgs);
-    if (!successCheck)
+    // The writer queues its outcomes before it completes the future, so this
+    // command's changes are among the ones published below
+    outcome.result = _writer->submit(command).result();
+    publishCommitted();
+    return outcome;
+}
+
+QFuture<TransactionResult> Library::borrowBookAsync(const int clientId, const BorrowRecord& record) const
+{
+    return _writer->submit(LibraryCommand::borrowBook(clientId, record));
+}
+
+QFuture<TransactionResult> Library::returnBookAsync(const int borrowRecordId) const
+{
+    return _writer->submit(LibraryCommand::returnBook(borrowRecordId));
+}
+
+QFuture<TransactionResult> Library::extendBorrowTimeAsync(const int borrowRecordId, const int days) const
+{
+    return _writer->submit(LibraryCommand::extendBorrowTime(borrowRecordId, days));
+}
+
+QFuture<TransactionResult> Library::addCopiesAsync(const int bookId, const int numCopies) const
+{
+    return _writer->submit(LibraryCommand::addCopies(bookId, numCopies));
+}
+
+void Library::publishCommitted()
+{
+    QList<CommandOutcome> outcomes;
     {
-        return TransactionResult::Failure_DBFailed;
+        QMutexLocker locker(&_committedMutex);
+        outcomes.swap(_committed);
     }
-    if (queryCheck.next()) {
-        return TransactionResult::Failure_AlreadyBorrowed;
-    }
-    //check if available copies
-    if (book->availableCopies()<=0)
-    {
-        return TransactionResult::Failure_NotAvailableBook;
+    if (!outcomes.isEmpty()) {
+        publish(outcomes);
     }
+}
 
-    args["client_id"] = clientId;
-    args["book_id"] = record.bookId;
-    args["borrow_date"] = record.borrowDate;
-    args["return_date"] = record.returnDate;
-    args["is_returned"] = 0;
-    args["borrowed_count"] = book->borrowedCount()+ 1;
-    auto [successB,queryB] = _dbManager->executeAction(DbAction::Insert, DbTable::BorrowRecords, args);
-    if (!successB)
-    {
-        return TransactionResult::Failure_DBFailed;
-    }
-
-    QVariantMap updateArgs;
-    updateArgs["id"] = book->id();
-    updateArgs["copies"] = book->copies();
-    updateArgs["borrowed_count"] = book->borrowedCount() + 1;
-    if (auto [success,queryR] = _dbManager->executeAction(DbAction::Update, DbTable::Books, updateArgs); !success)
-    {
-        qDebug()<< "Error updating book copies in database after borrowing, removing borrow:" << queryR.lastError().text();
-        // Rollback: Remove the borrow record if updating book copies fails
-        QVariantMap rollbackArgs;
-        rollbackArgs["id"] = queryB.lastInsertId().toInt();
-        if (auto [successRoll,queryRoll] =_dbManager->executeAction(DbAction::Delete, DbTable::BorrowRecords, rollbackArgs); !successRoll)
-        {
-            qDebug() << "Error rolling back borrow record after failed book update:" << queryRoll.lastError().text();
+void Library::publish(const QList<CommandOutcome>& outcomes)
+{
+    QList<int> bookIds;
+    for (const CommandOutcome& outcome : outcomes) {
+        if (outcome.bookId >= 0 && !bookIds.contains(outcome.bookId)) {
+            bookIds.append(outcome.bookId);
+        }
+    }
+    refreshBooks(bookIds);
+    for (const CommandOutcome& outcome : outcomes) {
+        if (outcome.event) {
+            emit changed(*outcome.event);
         }
+    }
+}
 
-        return TransactionResult::Failure_DBFailed;
+std::optional<BorrowRecord> Library::getBorrowRecordById(const int id) const
+{
+    auto [success, query] = _dbManager->executeAction(DbAction::Select, DbTable::BorrowRecords, {{"id", id}});
+    if (!success || !query.next())
+    {
+        return std::nullopt;
     }
-    loadBooks();
-    return TransactionResult::Success;
+    const BorrowRecord record = borrowRecordFromRow(RowDecoder<BorrowRecordSchema>(query).decode(query));
+    // One row by primary key; release the cursor rather than read past it
+    query.finish();
+    return record;
 }
 
-TransactionResult Library::returnBook(const int& borrowRecordId) const
+std::optional<Book> Library::getBookById(const int id) const
 {
-    QVariantMap args;
-    args["id"] = borrowRecordId;
-    args["is_returned"] = 1;
-    if (auto [success,query] = _dbManager->executeAction(DbAction::Update, DbTable::BorrowRecords, args); !success)
+    const std::shared_ptr<const Catalog> snapshot = catalog();
+    if (const Book* book = snapshot->book(id))
     {
-        return TransactionResult::Failure_DBFailed;
+        return *book;
     }
-    WindowManager::instance().handleEvent(EventType::BooksUpdated);
-    return TransactionResult::Success;
+    return std::nullopt;
+}
 
+QList<BorrowRecord> Library::getBorrowRecordsByClientId(const int clientId) const
+{
+    return selectBorrowRecords(*_dbManager, {{"client_id", clientId}});
 }
 
-bool Library::extendBorrowTime(const int& borrowRecordId, const int days) const
+namespace {
+
+// Asks for one row more than the page holds to learn whether another page follows
+template<typename T, typename Row>
+Page<T> readPage(const DbManager& db, const QVariantMap& where, const QString& orderColumn,
+                 const PageCursor& after, const int limit, T (*convert)(const Row&))
 {
-    QVariantMap selectArgs;
-    selectArgs["id"] = borrowRecordId;
-    auto [success,query] = _dbManager->executeAction(DbAction::Select, DbTable::BorrowRecords, selectArgs);
+    constexpr DbTable table = TableDescriptor<Row>::table;
+    Page<T> page;
+    auto [success, query] = db.selectPage(table, where, orderColumn, after, limit + 1);
     if (!success)
     {
-        qDebug() << "Error retrieving borrow record from database:" << query.lastError().text();
-        return false;
+        return page;
     }
-    if (query.next()) {
-        const QDate currentReturnDate = query.value("return_date").toDate();
-        const QDate newReturnDate = currentReturnDate.addDays(days);
-
-        QVariantMap updateArgs;
-        updateArgs["id"] = borrowRecordId;
-        updateArgs["return_date"] = newReturnDate.toString(Qt::ISODate);
-        if (auto [success,query] = _dbManager->executeAction(DbAction::Update, DbTable::BorrowRecords, updateArgs); !success)
+    const RowDecoder<Row> decoder(query);
+    page.items.reserve(limit);
+    while (query.next())
+    {
+        if (page.items.size() == limit)
         {
-            qDebug() << "Error updating borrow record in database:" << query.lastError().text();
-            return false;
+            page.hasMore = true;
+            break;
         }
-        return true;
+        page.items.append(convert(decoder.decode(query)));
+        page.next = DbManager::cursorAfter(table, orderColumn, query);
     }
-    return false;
+    query.finish();
+    return page;
+}
+
 }
 
-Book* Library::getBookById(int id) const
+Page<Book> Library::booksPage(const PageCursor& after, const int limit, const QString& orderBy) const
 {
-    QVariantMap args;
-    args["id"] = id;
-    auto [success,query] = _dbManager->executeAction(DbAction::Select, DbTable::Books, args);
+    if (orderBy != "id" && orderBy != "title")
+    {
+        qDebug() << "Unsupported book page order" << orderBy;
+        return {};
+    }
+    return readPage(*_dbManager, {}, orderBy, after, limit, &Library::bookFromRow);
+}
+
+Page<Client> Library::clientsPage(const PageCursor& after, const int limit) const
+{
+    return readPage(*_dbManager, {}, "id", after, limit, &Library::clientFromRow);
+}
+
+Page<BorrowRecord> Library::borrowRecordsPage(const int clientId, const PageCursor& after, const int limit) const
+{
+    return readPage(*_dbManager, {{"client_id", clientId}}, "id", after, limit, &Library::borrowRecordFromRow);
+}
+
+Page<BorrowRecord> Library::borrowHistoryPage(const PageCursor& after, const int limit) const
+{
+    return readPage(*_dbManager, {}, "id", after, limit, &Library::borrowRecordFromRow);
+}
+
+QList<BorrowRecordWithBook> Library::getClientBorrowHistory(const int clientId) const
+{
+    return selectClientBorrowHistory(*_dbManager, clientId);
+}
+
+QFuture<QList<BorrowRecordWithBook>> Library::getClientBorrowHistoryAsync(const int clientId) const
+{
+    return _worker->submit<QList<BorrowRecordWithBook>>([clientId](const DbManager& db) {
+        return selectClientBorrowHistory(db, clientId);
+    });
+}
+
+QList<BorrowRecordWithBook> Library::selectClientBorrowHistory(const DbManager& db, const int clientId)
+{
+    // Served by idx_borrow_records_client_book; columns are read by position.
+    // LEFT JOIN keeps records of removed books, open borrows included.
+    auto [success, query] = db.executeSql(
+        "SELECT r.id, r.book_id, r.client_id, r.borrow_date, r.return_date, r.is_returned, "
+        "COALESCE(b.title, ''), COALESCE(b.author, '') "
+        "FROM borrow_records r LEFT JOIN books b ON b.id = r.book_id "
+        "WHERE r.client_id = ? ORDER BY r.id",
+        {clientId});
     if (!success)
     {
-        qDebug() << "Error retrieving book from database:" << query.lastError().text();
-        return nullptr;
+        qDebug() << "Error retrieving borrow history from database:" << query.lastError().text();
+        return {};
     }
-    return query.next() ? new Book(getBookFromQuery(query)) : nullptr;
+
+    QList<BorrowRecordWithBook> rows;
+    while (query.next()) {
+        rows.append(BorrowRecordWithBook{
+            BorrowRecord{
+                query.value(0).toInt(),
+                query.value(1).toInt(),
+                query.value(2).toInt(),
+                query.value(3).toDate(),
+                query.value(4).toDate(),
+                query.value(5).toBool()
+            },
+            query.value(6).toString(),
+            query.value(7).toString()
+        });
+    }
+    return rows;
 }
 
-QList<BorrowRecord> Library::getBorrowRecordsByClientId(const int clientId) const
+QList<BorrowRecord> Library::selectBorrowRecords(const DbManager& db, const QVariantMap& args)
 {
-    QVariantMap args;
-    args["client_id"] = clientId;
-    auto [success,query] = _dbManager->executeAction(DbAction::Select, DbTable::BorrowRecords, args);
+    auto [success,query] = db.executeAction(DbAction::Select, DbTable::BorrowRecords, args);
     if (!success)
     {
         qDebug() << "Error retrieving borrow records from database:" << query.lastError().text();
@@ -436,93 +764,157 @@ QList<Book> Library::getBorrowedBooksByClient(const QString& clientId) const
         return books;
     }
 
-    for (const auto record: getBorrowRecordsListByQuery(query)) {
-        const int bookId = record.bookId;
-        // Assuming you have a way to get a Book object from its ID
-        for (const auto& book : _books) {
-            if (book.id() == bookId) {
-                books.append(book);
-                break;
-            }
+    const std::shared_ptr<const Catalog> snapshot = catalog();
+    for (const auto& record: getBorrowRecordsListByQuery(query)) {
+        if (const Book* book = snapshot->book(record.bookId)) {
+            books.append(*book);
         }
     }
     return books;
 }
 QList<BorrowRecord> Library::getBorrowRecordsListByQuery(QSqlQuery& query)
 {
+    const RowDecoder<BorrowRecordSchema> decoder(query);
     QList<BorrowRecord> records;
     while (query.next()) {
-            records.append(getBorrowRecordFromQuery(query));
+            records.append(borrowRecordFromRow(decoder.decode(query)));
     }
     return records;
 }
 
 QList<Client> Library::getClientsListByQuery(QSqlQuery& query)
 {
+    const RowDecoder<ClientSchema> decoder(query);
     QList<Client>clients;
     while (query.next()) {
-            clients.append(getClientFromQuery(query));
+            clients.append(clientFromRow(decoder.decode(query)));
     }
     return clients;
 }
 QList<Book> Library::getBooksListByQuery(QSqlQuery& query)
 {
+    const RowDecoder<BookSchema> decoder(query);
     QList<Book> books;
     while (query.next()) {
-        books.append(getBookFromQuery(query));
+        books.append(bookFromRow(decoder.decode(query)));
     }
     return books;
 }
 
-QList<BorrowRecord> Library::getBorrowRecordsByBookId(int bookId) const
+QList<BorrowRecord> Library::getBorrowRecordsByBookId(const int bookId) const
 {
-    QList<BorrowRecord> records;
-    QVariantMap args;
-    args["book_id"] = bookId;
-    auto [success,query] = _dbManager->executeAction(DbAction::Select, DbTable::BorrowRecords, args);
+    return selectBorrowRecords(*_dbManager, {{"book_id", bookId}});
+}
+
+QList<BorrowRecordWithClient> Library::getBookBorrowHistory(const int bookId) const
+{
+    return selectBookBorrowHistory(*_dbManager, bookId);
+}
+
+QFuture<QList<BorrowRecordWithClient>> Library::getBookBorrowHistoryAsync(const int bookId) const
+{
+    return _worker->submit<QList<BorrowRecordWithClient>>([bookId](const DbManager& db) {
+        return selectBookBorrowHistory(db, bookId);
+    });
+}
+
+QList<BorrowRecordWithClient> Library::selectBookBorrowHistory(const DbManager& db, const int bookId)
+{
+    // Served by idx_borrow_records_book; LEFT JOIN keeps records of removed clients
+    auto [success, query] = db.executeSql(
+        "SELECT r.id, r.book_id, r.client_id, r.borrow_date, r.return_date, r.is_returned, "
+        "COALESCE(c.name, ''), COALESCE(c.surname, '') "
+        "FROM borrow_records r LEFT JOIN clients c ON c.id = r.client_id "
+        "WHERE r.book_id = ? ORDER BY r.id",
+        {bookId});
     if (!success)
     {
-        qDebug() << "Error retrieving borrow records from database:" << query.lastError().text();
-        return records;
+        qDebug() << "Error retrieving borrow history from database:" << query.lastError().text();
+        return {};
+    }
+
+    QList<BorrowRecordWithClient> rows;
+    while (query.next()) {
+        rows.append(BorrowRecordWithClient{
+            BorrowRecord{
+                query.value(0).toInt(),
+                query.value(1).toInt(),
+                query.value(2).toInt(),
+                query.value(3).toDate(),
+                query.value(4).toDate(),
+                query.value(5).toBool()
+            },
+            query.value(6).toString(),
+            query.value(7).toString()
+        });
+    }
+    return rows;
+}
+
+std::optional<Book> Library::findBookByTitleAndAuthor(const QString& title, const QString& author) const
+{
+    const std::shared_ptr<const Catalog> snapshot = catalog();
+    if (const Book* book = snapshot->bookByTitleAndAuthor(title, author))
+    {
+        return *book;
+    }
+    return std::nullopt;
+}
+void Library::refreshBooks(const QList<int>& bookIds)
+{
+    QList<Book> books;
+    books.reserve(bookIds.size());
+    for (const int bookId : bookIds)
+    {
+        auto [success, query] = _dbManager->executeAction(DbAction::Select, DbTable::Books, {{"id", bookId}});
+        if (success && query.next())
+        {
+            books.append(bookFromRow(RowDecoder<BookSchema>(query).decode(query)));
+        }
+        query.finish();
+    }
+    if (books.isEmpty())
+    {
+        return;
+    }
+    // One new version for the whole batch
+    QList<int> rows;
+    editCatalog([&books, &rows](Catalog& catalog) {
+        for (const Book& book : std::as_const(books))
+        {
+            if (catalog.updateBook(book))
+            {
+                rows.append(static_cast<int>(catalog.bookRow(book.id())));
+            }
+        }
+    });
+    for (const int row : std::as_const(rows))
+    {
+        emit bookChanged(row);
     }
-    return records;
 }
 
-Book* Library::findBookByTitleAndAuthor(const QString& title, const QString& author) const
+Book Library::bookFromRow(const BookSchema& row)
 {
-    auto [success, query] = _dbManager->executeAction(DbAction::Select, DbTable::Books, {{"title", title}, {"author", author}});
-    if (!success)
-        return nullptr;
-    return query.next() ? new Book(getBookFromQuery(query)) : nullptr;
+    return Book(row.id, row.title, row.author, row.year, row.copies, row.borrowed_count);
 }
-Book Library::getBookFromQuery(const QSqlQuery& query)
+
+Client Library::clientFromRow(const ClientSchema& row)
 {
-    return Book(query.value("id").toInt(),
-                query.value("title").toString(),
-                query.value("author").toString(),
-                query.value("year").toInt(),
-                query.value("copies").toInt(),
-                query.value("borrowed_count").toInt());
+    return Client(row.id, row.name, row.surname, row.family);
 }
 
-Client Library::getClientFromQuery(const QSqlQuery& query)
+BorrowRecord Library::borrowRecordFromRow(const BorrowRecordSchema& row)
 {
+    return BorrowRecord{row.id, row.book_id, row.client_id, row.borrow_date, row.return_date, row.is_returned};
+}
 
-    return Client(
-                query.value("id").toInt(),
-                query.value("name").toString(),
-                query.value("surname").toString(),
-                query.value("family").toString());
+QList<QueryStats> Library::queryStats() const
+{
+    return QueryMetrics::instance().snapshot();
 }
 
-BorrowRecord Library::getBorrowRecordFromQuery(const QSqlQuery& query)
+void Library::dumpQueryStats() const
 {
-    return BorrowRecord{
-        query.value("id").toInt(),
-        query.value("book_id").toInt(),
-        query.value("client_id").toInt(),
-        query.value("borrow_date").toDate(),
-        query.value("return_date").toDate(),
-        query.value("is_returned").toBool()
-    };
+    QueryMetrics::instance().dump();
 }
@@ -0,0 +1,327 @@
+#include "libraryWriter.h"
+#include "tableDescriptor.h"
+#include <QDebug>
+#include <QSqlError>
+#include <QVariant>
+
+LibraryWriter::LibraryWriter(const DbManager& dbManager, CommittedHandler committed, const int maxBatch)
+    : m_dbManager(dbManager)
+    , m_committed(std::move(committed))
+    , m_maxBatch(qMax(1, maxBatch))
+{
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("LibraryWriter");
+    m_thread->start();
+}
+
+LibraryWriter::~LibraryWriter()
+{
+    // Commands queued before the stop request are still written
+    m_queue.push(PendingCommand{});
+    m_pending.release();
+    m_thread->wait();
+    delete m_thread;
+}
+
+QFuture<TransactionResult> LibraryWriter::submit(const LibraryCommand& command)
+{
+    auto promise = std::make_shared<QPromise<TransactionResult>>();
+    QFuture<TransactionResult> future = promise->future();
+    promise->start();
+    m_queue.push(PendingCommand{command, std::move(promise)});
+    m_pending.release();
+    return future;
+}
+
+void LibraryWriter::run()
+{
+    if (!m_dbManager.open()) {
+        qDebug() << "Error: writer connection failed; commands will fail.";
+    }
+    QList<PendingCommand> batch;
+    batch.reserve(m_maxBatch);
+    bool stopping = false;
+    while (!stopping) {
+        m_pending.acquire();
+        // This is the only thread that acquires, so what is available now stays available
+        const int extra = qMin(m_pending.available(), m_maxBatch - 1);
+        m_pending.acquire(extra);
+
+        batch.clear();
+        for (int i = 0; i <= extra; ++i) {
+            PendingCommand pending;
+            // Counted pushes are linked in a moment even if a slower producer is still mid-push
+            while (!m_queue.tryPop(pending)) {
+                QThread::yieldCurrentThread();
+            }
+            if (!pending.promise) {
+                stopping = true;
+                continue;
+            }
+            batch.append(std::move(pending));
+        }
+        if (!batch.isEmpty()) {
+            runBatch(batch);
+        }
+    }
+}
+
+void LibraryWriter::runBatch(QList<PendingCommand>& batch)
+{
+    QList<CommandOutcome> outcomes;
+    outcomes.reserve(batch.size());
+    {
+        // If BEGIN fails each command still runs, in a transaction of its own
+        DbTransaction transaction(m_dbManager);
+        for (const PendingCommand& pending : std::as_const(batch)) {
+            outcomes.append(execute(m_dbManager, pending.command));
+        }
+        if (transaction.isActive() && !transaction.commit()) {
+            qDebug() << "Error committing a batch of" << batch.size() << "commands.";
+            for (CommandOutcome& outcome : outcomes) {
+                outcome.result = TransactionResult::Failure_DBFailed;
+                outcome.event.reset();
+            }
+        }
+    }
+    // Handed over before the futures complete, so a caller woken by its
+    // future can already find its own outcome
+    if (m_committed) {
+        m_committed(outcomes);
+    }
+    for (qsizetype i = 0; i < batch.size(); ++i) {
+        batch[i].promise->addResult(outcomes.at(i).result);
+        batch[i].promise->finish();
+    }
+}
+
+CommandOutcome LibraryWriter::execute(const DbManager& dbManager, const LibraryCommand& command)
+{
+    switch (command.kind) {
+    case LibraryCommand::Kind::Borrow:
+        return borrowBook(dbManager, command);
+    case LibraryCommand::Kind::Return:
+        return returnBook(dbManager, command);
+    case LibraryCommand::Kind::Extend:
+        return extendBorrowTime(dbManager, command);
+    case LibraryCommand::Kind::AddCopies:
+        return addCopies(dbManager, command);
+    case LibraryCommand::Kind::RemoveCopy:
+        return removeCopy(dbManager, command);
+    }
+    return {};
+}
+
+CommandOutcome LibraryWriter::borrowBook(const DbManager& dbManager, const LibraryCommand& command)
+{
+    // All reads and writes of the borrow run in one transaction; any early
+    // return below rolls it back when the guard goes out of scope.
+    CommandOutcome outcome;
+    DbTransaction transaction(dbManager);
+    if (!transaction.isActive()) {
+        return outcome;
+    }
+
+    // Check if the client has already borrowed this book and not returned it yet
+    QVariantMap checkArgs;
+    checkArgs["client_id"] = command.clientId;
+    checkArgs["book_id"] = command.bookId;
+    checkArgs["is_returned"] = 0;
+    auto [successCheck, queryCheck] = dbManager.executeAction(DbAction::Select, DbTable::BorrowRecords, checkArgs);
+    if (!successCheck) {
+        return outcome;
+    }
+    const bool alreadyBorrowed = queryCheck.next();
+    queryCheck.finish();
+    if (alreadyBorrowed) {
+        outcome.result = TransactionResult::Failure_AlreadyBorrowed;
+        return outcome;
+    }
+
+    // Take a copy in a single conditional statement. The catalog may be stale
+    // when other desks share the database, so the row count decides, not the
+    // counters we have in memory.
+    auto [successTake, queryTake] = dbManager.executeSql(
+        "UPDATE books SET borrowed_count = borrowed_count + 1 WHERE id = ? AND borrowed_count < copies",
+        {command.bookId});
+    if (!successTake) {
+        qDebug() << "Error updating book copies in database after borrowing:" << queryTake.lastError().text();
+        return outcome;
+    }
+    if (queryTake.numRowsAffected() == 0) {
+        auto [successBook, queryBook] = dbManager.executeAction(DbAction::Select, DbTable::Books, {{"id", command.bookId}});
+        if (!successBook) {
+            return outcome;
+        }
+        if (!queryBook.next()) {
+            outcome.result = TransactionResult::Failure_BookNotFound;
+            return outcome;
+        }
+        const BookSchema book = RowDecoder<BookSchema>(queryBook).decode(queryBook);
+        outcome.result = book.copies > 0 ? TransactionResult::Failure_NotAvailableBook
+                                         : TransactionResult::Failure_NoCopies;
+        queryBook.finish();
+        // Our counters were out of date; have the catalog re-read them
+        outcome.bookId = command.bookId;
+        return outcome;
+    }
+
+    QVariantMap args;
+    args["client_id"] = command.clientId;
+    args["book_id"] = command.bookId;
+    args["borrow_date"] = command.borrowDate;
+    args["return_date"] = command.returnDate;
+    args["is_returned"] = 0;
+    auto [successInsert, queryInsert] = dbManager.executeAction(DbAction::Insert, DbTable::BorrowRecords, args);
+    if (!successInsert) {
+        return outcome;
+    }
+    const int recordId = queryInsert.lastInsertId().toInt();
+    if (!transaction.commit()) {
+        return outcome;
+    }
+    outcome.result = TransactionResult::Success;
+    outcome.bookId = command.bookId;
+    outcome.event = ChangeEvent::borrow(ChangeEvent::Kind::BorrowCreated, recordId, command.clientId, command.bookId,
+                                        command.borrowDate, command.returnDate, false);
+    return outcome;
+}
+
+CommandOutcome LibraryWriter::returnBook(const DbManager& dbManager, const LibraryCommand& command)
+{
+    CommandOutcome outcome;
+    DbTransaction transaction(dbManager);
+    if (!transaction.isActive()) {
+        return outcome;
+    }
+
+    // Listeners need the client and book, which only the record knows
+    auto [successRecord, queryRecord] = dbManager.executeAction(DbAction::Select, DbTable::BorrowRecords,
+                                                                {{"id", command.recordId}});
+    if (!successRecord) {
+        return outcome;
+    }
+    if (!queryRecord.next()) {
+        outcome.result = TransactionResult::Failure_RecordNotFound;
+        return outcome;
+    }
+    const BorrowRecordSchema record = RowDecoder<BorrowRecordSchema>(queryRecord).decode(queryRecord);
+    const int clientId = record.client_id;
+    const int bookId = record.book_id;
+    queryRecord.finish();
+
+    // Only the desk that flips the record gives the copy back, so returning
+    // the same record twice cannot inflate availability
+    auto [success, query] = dbManager.executeSql(
+        "UPDATE borrow_records SET is_returned = 1 WHERE id = ? AND is_returned = 0", {command.recordId});
+    if (!success) {
+        return outcome;
+    }
+    if (query.numRowsAffected() == 0) {
+        // Another return got there first; this one changed nothing
+        outcome.result = TransactionResult::Failure_AlreadyReturned;
+        return outcome;
+    }
+    if (auto [successBook, queryBook] = dbManager.executeSql(
+            "UPDATE books SET borrowed_count = borrowed_count - 1 WHERE id = ? AND borrowed_count > 0", {bookId});
+        !successBook) {
+        qDebug() << "Error updating book copies in database after returning:" << queryBook.lastError().text();
+        return outcome;
+    }
+    if (!transaction.commit()) {
+        return outcome;
+    }
+    outcome.result = TransactionResult::Success;
+    outcome.bookId = bookId;
+    outcome.event = ChangeEvent::borrow(ChangeEvent::Kind::BorrowReturned, command.recordId, clientId, bookId,
+                                        record.borrow_date, record.return_date, true);
+    return outcome;
+}
+
+CommandOutcome LibraryWriter::extendBorrowTime(const DbManager& dbManager, const LibraryCommand& command)
+{
+    CommandOutcome outcome;
+    DbTransaction transaction(dbManager);
+    if (!transaction.isActive()) {
+        return outcome;
+    }
+
+    auto [success, query] = dbManager.executeAction(DbAction::Select, DbTable::BorrowRecords, {{"id", command.recordId}});
+    if (!success) {
+        qDebug() << "Error retrieving borrow record from database:" << query.lastError().text();
+        return outcome;
+    }
+    if (!query.next()) {
+        outcome.result = TransactionResult::Failure_RecordNotFound;
+        return outcome;
+    }
+    const BorrowRecordSchema record = RowDecoder<BorrowRecordSchema>(query).decode(query);
+    const QDate newReturnDate = record.return_date.addDays(command.amount);
+    query.finish();
+
+    QVariantMap updateArgs;
+    updateArgs["id"] = command.recordId;
+    updateArgs["return_date"] = newReturnDate.toString(Qt::ISODate);
+    if (auto [successUpdate, queryUpdate] = dbManager.executeAction(DbAction::Update, DbTable::BorrowRecords, updateArgs);
+        !successUpdate) {
+        qDebug() << "Error updating borrow record in database:" << queryUpdate.lastError().text();
+        return outcome;
+    }
+    if (!transaction.commit()) {
+        return outcome;
+    }
+    outcome.result = TransactionResult::Success;
+    outcome.event = ChangeEvent::borrow(ChangeEvent::Kind::BorrowExtended, command.recordId, record.client_id,
+                                        record.book_id, record.borrow_date, newReturnDate, record.is_returned);
+    return outcome;
+}
+
+CommandOutcome LibraryWriter::addCopies(const DbManager& dbManager, const LibraryCommand& command)
+{
+    CommandOutcome outcome;
+    if (command.amount <= 0) {
+        qDebug() << "Invalid number of copies:" << command.amount;
+        return outcome;
+    }
+    // Relative update, so copies added at another desk are not overwritten
+    auto [success, query] = dbManager.executeSql("UPDATE books SET copies = copies + ? WHERE id = ?",
+                                                 {command.amount, command.bookId});
+    if (!success) {
+        qDebug() << "Error updating book copies in database:" << query.lastError().text();
+        return outcome;
+    }
+    if (query.numRowsAffected() == 0) {
+        outcome.result = TransactionResult::Failure_BookNotFound;
+        return outcome;
+    }
+    outcome.result = TransactionResult::Success;
+    outcome.bookId = command.bookId;
+    outcome.event = ChangeEvent::book(ChangeEvent::Kind::BookCopiesChanged, command.bookId);
+    return outcome;
+}
+
+CommandOutcome LibraryWriter::removeCopy(const DbManager& dbManager, const LibraryCommand& command)
+{
+    CommandOutcome outcome;
+    // Only a copy that is on the shelf can be removed
+    auto [success, query] = dbManager.executeSql(
+        "UPDATE books SET copies = copies - 1 WHERE id = ? AND copies > borrowed_count", {command.bookId});
+    if (!success) {
+        qDebug() << "Error updating book copies in database:" << query.lastError().text();
+        return outcome;
+    }
+    // Either way the catalog re-reads the counters, which may be stale
+    outcome.bookId = command.bookId;
+    if (query.numRowsAffected() == 0) {
+        auto [successBook, queryBook] = dbManager.executeAction(DbAction::Select, DbTable::Books, {{"id", command.bookId}});
+        if (!successBook) {
+            return outcome;
+        }
+        outcome.result = queryBook.next() ? TransactionResult::Failure_NoCopies : TransactionResult::Failure_BookNotFound;
+        queryBook.finish();
+        return outcome;
+    }
+    outcome.result = TransactionResult::Success;
+    outcome.event = ChangeEvent::book(ChangeEvent::Kind::BookCopiesChanged, command.bookId);
+    return outcome;
+}
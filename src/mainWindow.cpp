@@ -5,41 +5,42 @@
 #include "windows/familyviewdialog.h"
 #include "windows/bookdetaildialog.h"
 #include "windows/clientDetailDialog.h"
+#include "bookListModel.h"
 #include <QMessageBox>
 
 #include "windowManager.h"
 
-void MainWindow::handleEvent(const EventType event)
+void MainWindow::handleEvent(const ChangeBatch& changes)
 {
-    switch (event) {
-        case EventType::BooksUpdated:
-            updateBookList();
-            break;
-        case EventType::ClientsUpdated:
-            updateClientList();
-            break;
-        case EventType::FamiliesUpdated:
-            updateFamilyList();
-            break;
-        default:
-            break;
-    }
-}
-
-void MainWindow::handleEvent(const EventType event)
-{
-    switch (event) {
-        case EventType::BooksUpdated:
-            updateBookList();
-            break;
-        case EventType::ClientsUpdated:
-            updateClientList();
-            break;
-        case EventType::FamiliesUpdated:
-            updateFamilyList();
-            break;
-        default:
-            break;
+    // The book list follows Library through BookListModel
+    for (const ChangeEvent& change : changes) {
+        switch (change.kind) {
+            case ChangeEvent::Kind::CatalogReloaded:
+                updateClientList();
+                on_clientSearchEdit_textChanged(ui->clientSearchEdit->text());
+                updateFamilyList();
+                if (_bookModel->isFiltered()) {
+                    runBookSearch();
+                }
+                break;
+            case ChangeEvent::Kind::BookAdded:
+            case ChangeEvent::Kind::BookRemoved:
+                // Search results do not follow row inserts and removals
+                if (_bookModel->isFiltered()) {
+                    _searchTimer.start();
+                }
+                break;
+            case ChangeEvent::Kind::ClientAdded:
+            case ChangeEvent::Kind::ClientEdited:
+            case ChangeEvent::Kind::ClientRemoved:
+                updateClient(change.clientId);
+                break;
+            case ChangeEvent::Kind::FamilyAdded:
+                ui->familyListWidget->addItem(change.family);
+                break;
+            default:
+                break;
+        }
     }
 }
 
@@ -48,10 +49,12 @@ MainWindow::MainWindow(QWidget *parent)
     , ui(new Ui::MainWindow), _library(Library::instance())
 {
     ui->setupUi(this);
-    connect(_library, &Library::booksUpdated, this, &MainWindow::updateBookList);
-    connect(_library, &Library::clientsUpdated, this, &MainWindow::updateClientList);
-    connect(_library, &Library::familiesUpdated, this, &MainWindow::updateFamilyList);
-    updateBookList();
+    _bookModel = new BookListModel(_library, this);
+    ui->bookListView->setModel(_bookModel);
+    _searchTimer.setSingleShot(true);
+    _searchTimer.setInterval(80);
+    connect(&_searchTimer, &QTimer::timeout, this, &MainWindow::runBookSearch);
+    ui->clientResultsWidget->hide();
     updateClientList();
     updateFamilyList();
     WindowManager::instance().setMainWindow(this);
@@ -62,28 +65,71 @@ MainWindow::~MainWindow()
     delete ui;
 }
 
-void MainWindow::updateBookList() const
-{
+void MainWindow::updateClientList() {
+    // Built once and then kept up to date by updateClient(); searching only
+    // swaps it out for the results list
+    ui->clientListWidget->clear();
+    _clientItems.clear();
+    const QList<Client> clients = _library->allClients();
+    for (const Client& client : clients) {
+        addClientItem(ui->clientListWidget, _clientItems, client);
+    }
+}
 
-        ui->bookListWidget->clear();
-        for (const QList<Book>& books = _library->allBooks(); const Book& book : books) {
-            ui->bookListWidget->addItem(book.toString());
-        }
+void MainWindow::addClientItem(QListWidget* list, QHash<int, QListWidgetItem*>& items, const Client& client)
+{
+    auto* item = new QListWidgetItem(client.toString(), list);
+    item->setData(Qt::UserRole, client.id());
+    items.insert(client.id(), item);
+}
 
+void MainWindow::removeClientItem(QListWidget* list, QHash<int, QListWidgetItem*>& items, const int clientId)
+{
+    if (QListWidgetItem* item = items.take(clientId)) {
+        delete list->takeItem(list->row(item));
+    }
+}
 
+void MainWindow::on_clientSearchEdit_textChanged(const QString &text)
+{
+    // The trigram index answers in microseconds and the results list holds
+    // at most ClientResultLimit rows, so no debounce is needed. Clearing the
+    // search just shows the full list again.
+    const bool searching = !text.trimmed().isEmpty();
+    ui->clientResultsWidget->clear();
+    _resultItems.clear();
+    if (searching) {
+        for (const Client& client : _library->findClients(text, ClientResultLimit)) {
+            addClientItem(ui->clientResultsWidget, _resultItems, client);
+        }
+    }
+    ui->clientListWidget->setVisible(!searching);
+    ui->clientResultsWidget->setVisible(searching);
 }
 
-void MainWindow::updateClientList() {
-    ui->clientListWidget->clear();
-    const QList<Client>& clients = _library->allClients();
-    for (const Client& client : clients) {
-        ui->clientListWidget->addItem(client.toString());
+void MainWindow::updateClient(const int clientId)
+{
+    // The full list mirrors Library::allClients(): new clients are appended
+    // and removals keep the order. Search results only update in place.
+    const Client client = _library->getClientById(clientId);
+    if (client.id() < 0) {
+        removeClientItem(ui->clientListWidget, _clientItems, clientId);
+        removeClientItem(ui->clientResultsWidget, _resultItems, clientId);
+        return;
+    }
+    if (QListWidgetItem* item = _clientItems.value(clientId)) {
+        item->setText(client.toString());
+    } else {
+        addClientItem(ui->clientListWidget, _clientItems, client);
+    }
+    if (QListWidgetItem* item = _resultItems.value(clientId)) {
+        item->setText(client.toString());
     }
 }
 
 void MainWindow::updateFamilyList() {
     ui->familyListWidget->clear();
-    const QList<QString>& families = _library->allFamilies();
+    const QList<QString> families = _library->allFamilies();
     for (const QString& family : families) {
         ui->familyListWidget->addItem(family);
     }
@@ -94,26 +140,50 @@ void MainWindow::on_addBookButton_clicked()
     AddBookDialog dialog(this);
     if (dialog.exec() == QDialog::Accepted) {
         _library->addBook(dialog.getTitle(), dialog.getAuthor(), dialog.getYear(), dialog.getCopies());
-        onBooksUpdated();
     }
 }
-void MainWindow::on_bookListWidget_itemDoubleClicked(QListWidgetItem *item)
+void MainWindow::on_bookListView_doubleClicked(const QModelIndex &index)
 {
-    int bookId = item->data(Qt::UserRole).toInt()+1;
+    const int bookId = index.data(BookListModel::BookIdRole).toInt();
     Library* m_library = Library::instance();
-    Book* book =m_library->getBookById(bookId);
-    if (book) {
+    if (const std::optional<Book> book = m_library->getBookById(bookId)) {
         BookDetailDialog dialog(*book, m_library, this);
         WindowManager::instance().startNewWindow(&dialog);
     }
 
 }
+int MainWindow::selectedBookRow() const
+{
+    // View rows differ from library rows while a search is shown
+    const QModelIndex current = ui->bookListView->currentIndex();
+    return current.isValid() ? _library->bookRow(current.data(BookListModel::BookIdRole).toInt()) : -1;
+}
+
+void MainWindow::on_bookSearchEdit_textChanged(const QString &text)
+{
+    Q_UNUSED(text);
+    _searchTimer.start();
+}
+
+void MainWindow::runBookSearch()
+{
+    // A single letter matches most of the catalog and is not prefix-indexed; show everything instead
+    const QString text = ui->bookSearchEdit->text().trimmed();
+    if (text.size() < 2) {
+        _bookModel->clearFilter();
+        return;
+    }
+    QList<int> ids;
+    for (const Book& book : _library->searchBooks(text, SearchResultLimit)) {
+        ids.append(book.id());
+    }
+    _bookModel->setFilter(ids);
+}
+
 void MainWindow::on_removeBookButton_clicked()
 {
-    QListWidgetItem* item = ui->bookListWidget->currentItem();
-    if (item) {
-        int index = ui->bookListWidget->row(item);
-        _library->removeBook(index);
+    if (const int row = selectedBookRow(); row >= 0) {
+        _library->removeBook(row);
     } else {
         QMessageBox::warning(this, "No Selection", "Please select a book to remove.");
     }
@@ -121,10 +191,8 @@ void MainWindow::on_removeBookButton_clicked()
 
 void MainWindow::on_addCopiesButton_clicked()
 {
-    QListWidgetItem* item = ui->bookListWidget->currentItem();
-    if (item) {
-        int index = ui->bookListWidget->row(item);
-        _library->addCopies(index, 1);
+    if (const int row = selectedBookRow(); row >= 0) {
+        _library->addCopies(row, 1);
     } else {
         QMessageBox::warning(this, "No Selection", "Please select a book to add copies to.");
     }
@@ -148,29 +216,19 @@ void MainWindow::on_familyListWidget_doubleClicked(const QModelIndex &index)
     WindowManager::instance().startNewWindow(&dialog);
 }
 
-void MainWindow::on_clientListWidget_doubleClicked(const QModelIndex &index)
-{
-    int clientIndex = index.row();
-    const QList<Client>& clients = _library->allClients();
-
-    if (clientIndex >= 0 && clientIndex < clients.size()) {
-        const Client& client = clients[clientIndex];
-
-        ClientDetailDialog dialog(client, _library, this);
-        if (WindowManager::instance().startNewWindow(&dialog) == QDialog::Accepted) {
-            updateClientList();
-            updateBookList();
-            updateFamilyList();
-        }
-    }
-}
-
-void MainWindow::onBooksUpdated()
+void MainWindow::on_clientResultsWidget_doubleClicked(const QModelIndex &index)
 {
-    updateBookList();
+    on_clientListWidget_doubleClicked(index);
 }
 
-void MainWindow::onloadBorrowRecords()
+void MainWindow::on_clientListWidget_doubleClicked(const QModelIndex &index)
 {
-    this->updateBookList();
+    // Rows hold the client id, since search results do not follow allClients()
+    const Client client = _library->getClientById(index.data(Qt::UserRole).toInt());
+    if (client.id() < 0) {
+        return;
+    }
+    // Edits made in the dialog come back as change events
+    ClientDetailDialog dialog(client, _library, this);
+    WindowManager::instance().startNewWindow(&dialog);
 }
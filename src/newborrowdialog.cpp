@@ -23,14 +23,18 @@ NewBorrowDialog::~NewBorrowDialog()
 {
     delete ui;
 }
+QString NewBorrowDialog::bookText(const Book& book)
+{
+    return QString("%1 by %2 (%3) - %4 copies available")
+        .arg(book.title(), book.author(), QString::number(book.year()), QString::number(book.copies()));
+}
+
 void NewBorrowDialog::populateBookList()
 {
     ui->bookListWidget->clear();
     // Populate the book list
     for (const Book& book : m_availableBooks) {
-        QString bookText = QString("%1 by %2 (%3) - %4 copies available")
-                          .arg(book.title(), book.author(), QString::number(book.year()), QString::number(book.copies()));
-        ui->bookListWidget->addItem(bookText);
+        ui->bookListWidget->addItem(bookText(book));
     }
 
     // Set default return date to 2 weeks from today
@@ -38,12 +42,49 @@ void NewBorrowDialog::populateBookList()
     ui->returnDateEdit->setMinimumDate(QDate::currentDate().addDays(1));
     ui->returnDateEdit->setMaximumDate(QDate::currentDate().addDays(365));
 }
-void NewBorrowDialog::handleEvent(EventType event)
+void NewBorrowDialog::handleEvent(const ChangeBatch& changes)
 {
-    m_availableBooks.clear();
-    m_availableBooks= Library::instance()->getAvailableBooks();
-    populateBookList();
-    // This dialog does not need to handle any events currently.
+    for (const ChangeEvent& change : changes) {
+        switch (change.kind) {
+        case ChangeEvent::Kind::CatalogReloaded:
+            m_availableBooks = Library::instance()->getAvailableBooks();
+            populateBookList();
+            break;
+        case ChangeEvent::Kind::BookAdded:
+        case ChangeEvent::Kind::BookRemoved:
+        case ChangeEvent::Kind::BookCopiesChanged:
+        case ChangeEvent::Kind::BorrowCreated:
+        case ChangeEvent::Kind::BorrowReturned:
+            updateBook(change.bookId);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void NewBorrowDialog::updateBook(const int bookId)
+{
+    qsizetype row = -1;
+    for (qsizetype i = 0; i < m_availableBooks.size(); ++i) {
+        if (m_availableBooks.at(i).id() == bookId) {
+            row = i;
+            break;
+        }
+    }
+    const std::optional<Book> book = Library::instance()->getBookById(bookId);
+    // Same test as Library::getAvailableBooks
+    const bool available = book && book->copies() > 0;
+    if (row >= 0 && !available) {
+        m_availableBooks.removeAt(row);
+        delete ui->bookListWidget->takeItem(static_cast<int>(row));
+    } else if (row >= 0) {
+        m_availableBooks[row] = *book;
+        ui->bookListWidget->item(static_cast<int>(row))->setText(bookText(*book));
+    } else if (available) {
+        m_availableBooks.append(*book);
+        ui->bookListWidget->addItem(bookText(*book));
+    }
 }
 
 Book NewBorrowDialog::getSelectedBook() const
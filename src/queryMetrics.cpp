@@ -0,0 +1,169 @@
+#include "queryMetrics.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Upper bound of a histogram bucket: 2^(bucket / 4) microseconds
+qint64 bucketUpperNs(const int bucket)
+{
+    return static_cast<qint64>(std::pow(2.0, (bucket + 1) / 4.0) * 1000.0);
+}
+
+QString formatMs(const qint64 ns)
+{
+    return QString::number(ns / 1e6, 'f', 3);
+}
+
+}
+
+qint64 QueryStats::percentileNs(const double percentile) const
+{
+    if (count == 0) {
+        return 0;
+    }
+    const auto target = static_cast<quint64>(std::ceil(count * percentile / 100.0));
+    quint64 seen = 0;
+    for (int bucket = 0; bucket < BucketCount; ++bucket) {
+        seen += histogram[bucket];
+        if (seen >= target) {
+            return std::min(bucketUpperNs(bucket), maxNs);
+        }
+    }
+    return maxNs;
+}
+
+void QueryStats::merge(const QueryStats& other)
+{
+    if (label.isEmpty()) {
+        label = other.label;
+    }
+    count += other.count;
+    totalNs += other.totalNs;
+    maxNs = std::max(maxNs, other.maxNs);
+    for (int bucket = 0; bucket < BucketCount; ++bucket) {
+        histogram[bucket] += other.histogram[bucket];
+    }
+}
+
+int QueryMetrics::bucketFor(const qint64 elapsedNs)
+{
+    if (elapsedNs <= 1000) {
+        return 0;
+    }
+    const int bucket = static_cast<int>(std::log2(elapsedNs / 1000.0) * 4.0);
+    return std::clamp(bucket, 0, QueryStats::BucketCount - 1);
+}
+
+QueryMetrics::Shard& QueryMetrics::localShard()
+{
+    // QueryMetrics is a singleton, so one shard per thread is enough
+    thread_local std::shared_ptr<Shard> shard;
+    if (!shard) {
+        shard = std::make_shared<Shard>();
+        QMutexLocker locker(&m_shardsMutex);
+        m_shards.append(shard);
+    }
+    return *shard;
+}
+
+void QueryMetrics::record(const QString& label, const qint64 elapsedNs)
+{
+    Shard& shard = localShard();
+    QMutexLocker locker(&shard.mutex);
+    QueryStats& stats = shard.stats[label];
+    if (stats.label.isEmpty()) {
+        stats.label = label;
+    }
+    ++stats.count;
+    stats.totalNs += elapsedNs;
+    stats.maxNs = std::max(stats.maxNs, elapsedNs);
+    ++stats.histogram[bucketFor(elapsedNs)];
+}
+
+void QueryMetrics::recordSlow(const QString& label, const qint64 elapsedNs, const QString& sql,
+                              const QVariantList& boundValues)
+{
+    // Formatted before taking the log lock, which only covers the write
+    QStringList values;
+    for (const QVariant& value : boundValues) {
+        values << value.toString();
+    }
+    const QString line = QString("%1 slow query %2 ms [%3] %4 -- params: (%5)")
+        .arg(QDateTime::currentDateTime().toString(Qt::ISODateWithMs), formatMs(elapsedNs), label, sql, values.join(", "));
+    QMutexLocker locker(&m_logMutex);
+    if (m_slowLog.isOpen()) {
+        QTextStream(&m_slowLog) << line << '\n';
+        m_slowLog.flush();
+    } else {
+        qDebug().noquote() << line;
+    }
+}
+
+void QueryMetrics::setSlowQueryThresholdMs(const int thresholdMs)
+{
+    m_slowThresholdNs.store(static_cast<qint64>(thresholdMs) * 1'000'000, std::memory_order_relaxed);
+}
+
+void QueryMetrics::setSlowQueryLogPath(const QString& path)
+{
+    QMutexLocker locker(&m_logMutex);
+    if (m_slowLog.isOpen()) {
+        m_slowLog.close();
+    }
+    if (path.isEmpty()) {
+        return;
+    }
+    m_slowLog.setFileName(path);
+    if (!m_slowLog.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        qDebug() << "Error opening slow query log" << path << ":" << m_slowLog.errorString();
+    }
+}
+
+QList<QueryStats> QueryMetrics::snapshot() const
+{
+    QMutexLocker shardsLocker(&m_shardsMutex);
+    const QList<std::shared_ptr<Shard>> shards = m_shards;
+    shardsLocker.unlock();
+
+    QHash<QString, QueryStats> merged;
+    for (const std::shared_ptr<Shard>& shard : shards) {
+        QMutexLocker locker(&shard->mutex);
+        for (auto it = shard->stats.cbegin(); it != shard->stats.cend(); ++it) {
+            merged[it.key()].merge(it.value());
+        }
+    }
+    QList<QueryStats> stats = merged.values();
+    std::sort(stats.begin(), stats.end(), [](const QueryStats& a, const QueryStats& b) {
+        return a.totalNs > b.totalNs;
+    });
+    return stats;
+}
+
+void QueryMetrics::reset()
+{
+    QMutexLocker shardsLocker(&m_shardsMutex);
+    for (const std::shared_ptr<Shard>& shard : std::as_const(m_shards)) {
+        QMutexLocker locker(&shard->mutex);
+        shard->stats.clear();
+    }
+}
+
+void QueryMetrics::dump() const
+{
+    const QList<QueryStats> stats = snapshot();
+    if (stats.isEmpty()) {
+        return;
+    }
+    qDebug() << "Query statistics (ms): label count total avg p50 p95 p99 max";
+    for (const QueryStats& s : stats) {
+        qDebug().noquote() << QString("  %1 %2 %3 %4 %5 %6 %7 %8")
+            .arg(s.label).arg(s.count)
+            .arg(formatMs(s.totalNs), formatMs(s.averageNs()), formatMs(s.percentileNs(50)),
+                 formatMs(s.percentileNs(95)), formatMs(s.percentileNs(99)), formatMs(s.maxNs));
+    }
+}
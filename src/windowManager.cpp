@@ -6,6 +6,7 @@
 #include <QObject>
 
 #include <QApplication>
+#include <utility>
 
 
 int WindowManager::startNewWindow(AbstractWindow* window)
@@ -26,18 +27,43 @@ void WindowManager::setMainWindow(MainWindow* mainWindow)
 {
     m_mainWindow = mainWindow;
 }
-void WindowManager::handleEvent(const EventType event)
+void WindowManager::postEvent(const ChangeEvent& event)
 {
-    for (const auto& window : m_windows) {
-        if (window) {
-            window->handleEvent(event);
+    if (m_pendingSet.contains(event)) {
+        return;
+    }
+    m_pendingSet.insert(event);
+    m_pendingEvents.append(event);
+
+    if (!m_deliveryScheduled) {
+        m_deliveryScheduled = true;
+        QMetaObject::invokeMethod(this, &WindowManager::deliverPendingEvents, Qt::QueuedConnection);
+    }
+}
+
+void WindowManager::deliverPendingEvents()
+{
+    // Handlers may post again; those changes go out on the next tick
+    const ChangeBatch changes = std::exchange(m_pendingEvents, {});
+    m_pendingSet.clear();
+    m_deliveryScheduled = false;
+
+    // A handler can open or close windows, so iterate over a copy
+    const QList<AbstractWindow*> windows = m_windows;
+    for (AbstractWindow* window : windows) {
+        if (window && m_windows.contains(window)) {
+            window->handleEvent(changes);
         }
     }
-    m_mainWindow->handleEvent(event);
+    if (m_mainWindow) {
+        m_mainWindow->handleEvent(changes);
+    }
 }
 
 WindowManager::WindowManager()
 {
+    // Library has no GUI dependency; its notifications are fanned out to the windows here
+    connect(Library::instance(), &Library::changed, this, &WindowManager::postEvent);
     connect(qApp, &QApplication::aboutToQuit, this, [this]() {
         qDebug() << "Application is about to quit. Cleaning up all managed windows.";
         for (QWidget* window : m_windows) {
@@ -0,0 +1,58 @@
+#include <QtTest>
+#include <QThread>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "atomicSnapshot.h"
+
+class AtomicSnapshotTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void heldVersionSurvivesStore();
+    void readersNeverSeeAnOlderVersion();
+};
+
+void AtomicSnapshotTest::heldVersionSurvivesStore()
+{
+    AtomicSnapshot<int> snapshot(std::make_shared<const int>(1));
+    const std::shared_ptr<const int> held = snapshot.load();
+    snapshot.store(std::make_shared<const int>(2));
+    QCOMPARE(*held, 1);
+    QCOMPARE(*snapshot.load(), 2);
+}
+
+void AtomicSnapshotTest::readersNeverSeeAnOlderVersion()
+{
+    constexpr int versions = 20000;
+    AtomicSnapshot<int> snapshot(std::make_shared<const int>(0));
+    std::atomic<bool> done = false;
+    std::atomic<int> regressions = 0;
+    std::vector<std::unique_ptr<QThread>> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back(QThread::create([&]() {
+            int last = 0;
+            while (!done.load()) {
+                const int seen = *snapshot.load();
+                if (seen < last) {
+                    ++regressions;
+                }
+                last = seen;
+            }
+        }));
+        readers.back()->start();
+    }
+    for (int v = 1; v <= versions; ++v) {
+        snapshot.store(std::make_shared<const int>(v));
+    }
+    done = true;
+    for (const auto& reader : readers) {
+        QVERIFY(reader->wait());
+    }
+    QCOMPARE(regressions.load(), 0);
+    QCOMPARE(*snapshot.load(), versions);
+}
+
+QTEST_APPLESS_MAIN(AtomicSnapshotTest)
+#include "atomicSnapshotTest.moc"
@@ -0,0 +1,84 @@
+#include <QtTest>
+#include "chunkedList.h"
+
+// Chunks of four keep chunk boundaries within a handful of rows
+using SmallList = ChunkedList<int, 4>;
+
+class ChunkedListTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTripsThroughQList();
+    void editsOfACopyLeaveTheOriginal();
+    void removeAtShiftsAcrossChunks();
+    void appendAfterRemovalFillsTheLastChunk();
+
+private:
+    static QList<int> range(int count);
+};
+
+QList<int> ChunkedListTest::range(const int count)
+{
+    QList<int> rows;
+    for (int i = 0; i < count; ++i) {
+        rows << i;
+    }
+    return rows;
+}
+
+void ChunkedListTest::roundTripsThroughQList()
+{
+    const SmallList list(range(10));
+    QCOMPARE(list.size(), 10);
+    QCOMPARE(list.toList(), range(10));
+    QCOMPARE(list.last(), 9);
+    QList<int> iterated;
+    for (const int value : list) {
+        iterated << value;
+    }
+    QCOMPARE(iterated, range(10));
+    QVERIFY(SmallList().isEmpty());
+}
+
+void ChunkedListTest::editsOfACopyLeaveTheOriginal()
+{
+    const SmallList original(range(10));
+    SmallList copy = original;
+    copy.replace(5, 50);
+    copy.append(10);
+    copy.removeAt(0);
+    QCOMPARE(original.toList(), range(10));
+    QCOMPARE(copy.at(4), 50);
+    QCOMPARE(copy.size(), 10);
+}
+
+void ChunkedListTest::removeAtShiftsAcrossChunks()
+{
+    SmallList list(range(10));
+    QList<int> expected = range(10);
+    for (const int row : {1, 4, 7, 0, 5}) {
+        list.removeAt(row);
+        expected.removeAt(row);
+        QCOMPARE(list.toList(), expected);
+    }
+    while (!list.isEmpty()) {
+        list.removeAt(list.size() - 1);
+    }
+    QCOMPARE(list.size(), 0);
+}
+
+void ChunkedListTest::appendAfterRemovalFillsTheLastChunk()
+{
+    SmallList list(range(8));
+    list.removeAt(2);
+    list.append(8);
+    list.append(9);
+    QList<int> expected = range(10);
+    expected.removeAt(2);
+    QCOMPARE(list.toList(), expected);
+    QCOMPARE(list.at(8), 9);
+}
+
+QTEST_APPLESS_MAIN(ChunkedListTest)
+#include "chunkedListTest.moc"
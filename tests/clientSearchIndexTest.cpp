@@ -0,0 +1,78 @@
+#include <QtTest>
+#include <algorithm>
+#include "clientSearchIndex.h"
+
+class ClientSearchIndexTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void findsDespiteATypo();
+    void removeFixesUpTheMovedEntry();
+    void copyIsIndependent();
+
+private:
+    static QList<int> ids(const QList<ClientSearchIndex::Match>& matches);
+};
+
+QList<int> ClientSearchIndexTest::ids(const QList<ClientSearchIndex::Match>& matches)
+{
+    QList<int> result;
+    for (const ClientSearchIndex::Match& match : matches) {
+        result << match.clientId;
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+void ClientSearchIndexTest::findsDespiteATypo()
+{
+    ClientSearchIndex index;
+    index.insert(Client(1, "Maya", "Cohen", "Cohen"));
+    index.insert(Client(2, "Itai", "Levi", "Levi"));
+    const QList<ClientSearchIndex::Match> matches = index.find("Mayya Cohen", 5);
+    QVERIFY(!matches.isEmpty());
+    QCOMPARE(matches.first().clientId, 1);
+}
+
+void ClientSearchIndexTest::removeFixesUpTheMovedEntry()
+{
+    // All three share the family's trigrams, so they share postings. Removing
+    // the first moves the last slot into its place in each of them; removing
+    // that moved client afterwards only works if its positions were updated.
+    ClientSearchIndex index;
+    index.insert(Client(1, "Noa", "Harel", "Harel"));
+    index.insert(Client(2, "Ari", "Harel", "Harel"));
+    index.insert(Client(3, "Gal", "Harel", "Harel"));
+    QCOMPARE(ids(index.find("Harel", 10)), QList<int>({1, 2, 3}));
+
+    index.remove(1);
+    QCOMPARE(ids(index.find("Harel", 10)), QList<int>({2, 3}));
+    index.remove(3);
+    QCOMPARE(ids(index.find("Harel", 10)), QList<int>({2}));
+    index.remove(2);
+    QVERIFY(index.find("Harel", 10).isEmpty());
+    QCOMPARE(index.size(), 0);
+
+    // Freed slots are reused and indexed again from scratch
+    index.insert(Client(4, "Adi", "Harel", "Harel"));
+    index.insert(Client(5, "Roni", "Harel", "Harel"));
+    QCOMPARE(ids(index.find("Harel", 10)), QList<int>({4, 5}));
+    index.update(Client(4, "Adi", "Golan", "Golan"));
+    QCOMPARE(ids(index.find("Harel", 10)), QList<int>({5}));
+    QCOMPARE(ids(index.find("Golan", 10)), QList<int>({4}));
+}
+
+void ClientSearchIndexTest::copyIsIndependent()
+{
+    ClientSearchIndex original;
+    original.insert(Client(1, "Noa", "Katz", "Katz"));
+    original.insert(Client(2, "Omer", "Katz", "Katz"));
+    ClientSearchIndex copy = original;
+    copy.remove(1);
+    QCOMPARE(ids(original.find("Katz", 10)), QList<int>({1, 2}));
+    QCOMPARE(ids(copy.find("Katz", 10)), QList<int>({2}));
+}
+
+QTEST_APPLESS_MAIN(ClientSearchIndexTest)
+#include "clientSearchIndexTest.moc"
@@ -0,0 +1,105 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <memory>
+#include "dbConfig.h"
+#include "dbManager.h"
+
+class DbTransactionTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void rolledBackSavepointKeepsOuterWork();
+    void committedSavepointGoesWithOuterRollback();
+    void unfinishedTransactionRollsBack();
+
+private:
+    bool addBook(const QString& title) const;
+    int countBooks(const QString& title) const;
+
+    QTemporaryDir m_dir;
+    std::unique_ptr<DbManager> m_dbManager;
+};
+
+void DbTransactionTest::init()
+{
+    QVERIFY(m_dir.isValid());
+    DbConfig config;
+    config.databaseName = m_dir.filePath(QString("%1.db").arg(QTest::currentTestFunction()));
+    m_dbManager = std::make_unique<DbManager>(config);
+    QVERIFY(m_dbManager->open());
+    QVERIFY(m_dbManager->createTables());
+}
+
+void DbTransactionTest::cleanup()
+{
+    m_dbManager.reset();
+}
+
+bool DbTransactionTest::addBook(const QString& title) const
+{
+    return m_dbManager->executeAction(DbAction::Insert, DbTable::Books,
+                                      {{"title", title}, {"author", "Test"}, {"year", 2000}, {"copies", 1}}).first;
+}
+
+int DbTransactionTest::countBooks(const QString& title) const
+{
+    auto [success, query] = m_dbManager->executeSql("SELECT COUNT(*) FROM books WHERE title = ?", {title});
+    const int count = success && query.next() ? query.value(0).toInt() : -1;
+    query.finish();
+    return count;
+}
+
+void DbTransactionTest::rolledBackSavepointKeepsOuterWork()
+{
+    {
+        DbTransaction outer(*m_dbManager);
+        QVERIFY(outer.isActive());
+        QVERIFY(addBook("outer"));
+        {
+            DbTransaction inner(*m_dbManager);
+            QVERIFY(inner.isActive());
+            QVERIFY(addBook("inner"));
+            // Leaving the scope without commit() rolls back to the savepoint
+        }
+        QCOMPARE(countBooks("inner"), 0);
+        QVERIFY(outer.commit());
+    }
+    QCOMPARE(countBooks("outer"), 1);
+    QCOMPARE(countBooks("inner"), 0);
+    QVERIFY(!m_dbManager->inTransaction());
+}
+
+void DbTransactionTest::committedSavepointGoesWithOuterRollback()
+{
+    {
+        DbTransaction outer(*m_dbManager);
+        QVERIFY(addBook("outer"));
+        DbTransaction inner(*m_dbManager);
+        QVERIFY(addBook("inner"));
+        QVERIFY(inner.commit());
+        outer.rollback();
+    }
+    QCOMPARE(countBooks("outer"), 0);
+    QCOMPARE(countBooks("inner"), 0);
+}
+
+void DbTransactionTest::unfinishedTransactionRollsBack()
+{
+    {
+        DbTransaction transaction(*m_dbManager);
+        QVERIFY(addBook("dropped"));
+    }
+    QCOMPARE(countBooks("dropped"), 0);
+    // The write lock was released, so a new transaction can start
+    DbTransaction next(*m_dbManager);
+    QVERIFY(next.isActive());
+    QVERIFY(addBook("kept"));
+    QVERIFY(next.commit());
+    QCOMPARE(countBooks("kept"), 1);
+}
+
+QTEST_GUILESS_MAIN(DbTransactionTest)
+#include "dbTransactionTest.moc"
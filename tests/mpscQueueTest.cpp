@@ -0,0 +1,70 @@
+#include <QtTest>
+#include <QThread>
+#include <memory>
+#include <vector>
+#include "mpscQueue.h"
+
+class MpscQueueTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void popsInPushOrderOnOneThread();
+    void keepsEveryProducersOrder();
+};
+
+void MpscQueueTest::popsInPushOrderOnOneThread()
+{
+    MpscQueue<int> queue;
+    int value = -1;
+    QVERIFY(!queue.tryPop(value));
+    for (int i = 0; i < 100; ++i) {
+        queue.push(i);
+    }
+    for (int i = 0; i < 100; ++i) {
+        QVERIFY(queue.tryPop(value));
+        QCOMPARE(value, i);
+    }
+    QVERIFY(!queue.tryPop(value));
+}
+
+void MpscQueueTest::keepsEveryProducersOrder()
+{
+    constexpr int producers = 4;
+    constexpr int perProducer = 20000;
+    // Producer in the high bits, sequence number in the low ones
+    MpscQueue<qint64> queue;
+    std::vector<std::unique_ptr<QThread>> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back(QThread::create([&queue, p]() {
+            for (int i = 0; i < perProducer; ++i) {
+                queue.push((qint64(p) << 32) | i);
+            }
+        }));
+        threads.back()->start();
+    }
+
+    std::vector<int> next(producers, 0);
+    int received = 0;
+    while (received < producers * perProducer) {
+        qint64 value = 0;
+        if (!queue.tryPop(value)) {
+            QThread::yieldCurrentThread();
+            continue;
+        }
+        const int producer = int(value >> 32);
+        const int sequence = int(value & 0xffffffff);
+        QVERIFY(producer >= 0 && producer < producers);
+        QCOMPARE(sequence, next[producer]);
+        ++next[producer];
+        ++received;
+    }
+    for (const auto& thread : threads) {
+        QVERIFY(thread->wait());
+    }
+    qint64 value = 0;
+    QVERIFY(!queue.tryPop(value));
+}
+
+QTEST_APPLESS_MAIN(MpscQueueTest)
+#include "mpscQueueTest.moc"